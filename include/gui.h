@@ -8,29 +8,75 @@
 #include <math.h>
 #include <errno.h>
 
+/* -------------------- Zoom / level of detail -------------------- */
+#define ZOOM_MIN       0.05
+#define ZOOM_MAX       4.0
+#define ZOOM_STEP      1.25
+#define LOD_TEXT_ZOOM  0.5   // below this "Sans 18" cells are no longer legible
+#define HEATMAP_CELL   24    // heatmap cell size in unzoomed pixels
+
 /* -------------------- Data Structures -------------------- */
 
+typedef enum { OP_NONE, OP_SWAP, OP_SCALE, OP_ADD } RowOpType;
+
+// Structured record of the row operation behind an arrow step (rows 0-based)
+typedef struct {
+    RowOpType type;
+    int dest;          // row that changes (first row of a swap)
+    int src;           // row added from (second row of a swap), unused for scale
+    double coeff;      // scale factor, or multiple of src added to dest
+} RowOp;
+
 typedef struct {
     double **matrix;   // NULL for arrow step
     int rows;
     int cols;
-    char *above_arrow; // NULL if this is a matrix step
+    char *above_arrow; // label text, formatted lazily by step_label(); NULL until then
+    RowOp op;          // OP_NONE for a matrix step
+
+    /* Display cache filled by layout_step(), empty until laid out */
+    int laid_out;
+    char *cell_text;   // formatted cells, NUL-separated, row-major
+    int *cell_offset;  // start of each cell in cell_text
+    int *cell_width;   // unpadded text width of each cell
+    int *col_width;    // padded column widths
+    int *row_height;   // padded row heights
+    int label_w;       // arrow label extent
+    int label_h;
+    cairo_surface_t *text_cache;  // recorded cells or label, see draw_steps()
 } MatrixStep;
 
+// What ref()/rref() record into a StepList
+typedef enum {
+    RECORD_STEPS,      // operations and a matrix snapshot after each (default)
+    RECORD_OPS,        // operations only, no snapshots
+    RECORD_NONE        // nothing; plain elimination
+} StepRecording;
+
 typedef struct {
     MatrixStep *steps;
     int count;
+    int capacity;        // allocated steps, grows geometrically
+    StepRecording recording;
+    void *mapping;       // mmap'd session file backing the steps, NULL if heap-owned
+    size_t mapping_size;
+    double **row_ptrs;   // shared row pointer block for mapped steps
+    GDestroyNotify free_text_cache;  // set by the renderer that fills text_cache
 } StepList;
 
 typedef struct {
     GtkWidget *grid;
     GtkWidget *drawing_area;
+    GtkWidget *draw_scrolled;  // scrolled window around drawing_area
     GtkWidget *rows_entry;
     GtkWidget *cols_entry;
+    GtkWidget *session_entry;
     GtkWidget ***matrix_entries;
     double **matrix_data;
     char *above_arrow;
     StepList step_list;  // store all matrices & arrows
+    double zoom;         // drawing area scale factor, 1.0 = full size
+    gboolean show_labels;// format and draw operation labels above arrows
     int rows;
     int cols;
 } AppData;
@@ -40,14 +86,15 @@ void clear_matrix(AppData *app);
 void create_matrix(GtkButton *btn, gpointer user_data);
 void render_matrix(GtkButton *btn, gpointer user_data);
 void render_rref_matrix(GtkButton *btn, gpointer user_data);
-// Draw a single matrix; returns total width in pixels for layout purposes
-int draw_matrix(cairo_t *cr, MatrixStep *step, int start_x, int start_y, int *out_height);
+void save_session_clicked(GtkButton *btn, gpointer user_data);
+void load_session_clicked(GtkButton *btn, gpointer user_data);
+void zoom_in_clicked(GtkButton *btn, gpointer user_data);
+void zoom_out_clicked(GtkButton *btn, gpointer user_data);
+void labels_toggled(GtkCheckButton *check, gpointer user_data);
 
 // Draw all steps (matrices + arrows) in the drawing area
 void draw_func(GtkDrawingArea *area, cairo_t *cr,
                int width, int height, gpointer user_data);
-void draw_arrow(cairo_t *cr, double x1, double y1,
-                double x2, double y2, double head_size);
 void activate(GtkApplication *app, gpointer user_data);
 
 #endif
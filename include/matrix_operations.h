@@ -14,11 +14,18 @@ void swap_rows(int r, int c, double M[r][c], int i, int j);
 void scale_row(int r, int c, double M[r][c], double k, int row);
 void add_row(int r, int c, double M[r][c], double k, int src, int dest);
 void print_matrix(int r, int c, double M[r][c]);
-void clean_matrix(int r, int c, double M[r][c]);
+// Zero entries at or below tol, the noise level of the values (see rank_tolerance)
+void clean_matrix(int r, int c, double M[r][c], double tol);
+void clean_row(int r, int c, double M[r][c], int row, double tol);
+void copy_row(int r, int c, double M[r][c], double prev[r][c], int row);
+int row_changed(int r, int c, double M[r][c], double prev[r][c], int row, double tol);
 void copy_matrix(int rows, int cols, double M[rows][cols], double prev[rows][cols]);
 int matrix_changed(int rows, int cols, double M[rows][cols], double prev[rows][cols]);
+double rank_tolerance(int rows, int cols, double M[rows][cols]);
 void record_step(AppData *app, int rows, int cols, double M[rows][cols]);
-void record_arrow(AppData *app, const char *text);
+void record_op(AppData *app, RowOpType type, int dest, int src, double coeff);
+const char *step_label(MatrixStep *step);
+void free_step_list(StepList *list);
 int gcd(int a, int b);
 void format_fraction(double value, char *buffer, size_t size);
 void format_for_step(double value, char *buffer, size_t size);
@@ -0,0 +1,25 @@
+#ifndef MIXED_PRECISION_H_INCLUDED
+#define MIXED_PRECISION_H_INCLUDED
+
+#include "gui.h"
+
+#define MIXED_MAX_REFINE 10   // double-precision refinement steps before giving up
+
+/*
+ * Mixed-precision path: the O(n^3) LU factorisation runs in float with SIMD
+ * row updates, then the solution is refined to double accuracy with O(n^2)
+ * residual / correction steps. Least-squares problems are solved through the
+ * augmented system [I A; A^T 0] [r; x] = [b; 0] so they share the same path.
+ */
+
+// Solve A x = b (rows == cols) or least squares min ||A x - b|| (rows > cols).
+// Returns the number of refinement steps used, or -1 if A is numerically rank
+// deficient or refinement did not converge (the caller should fall back).
+int solve_mixed(int rows, int cols, double A[rows][cols], const double b[rows], double x[cols]);
+
+// Final RREF of an augmented system M = [A | b] without recording steps.
+// Returns 1 if M was reduced on the mixed path, 0 if M is untouched because
+// A is underdetermined or rank deficient and the exact rref() path is needed.
+int rref_mixed(int rows, int cols, double M[rows][cols]);
+
+#endif // MIXED_PRECISION_H_INCLUDED
@@ -0,0 +1,35 @@
+#ifndef RENDER_H_INCLUDED
+#define RENDER_H_INCLUDED
+
+#include "gui.h"
+
+#define STEPS_MARGIN 60   // blank border around a rendered step history
+#define BRACKET_PAD  10   // gap between a matrix and its brackets
+
+/* Cell size assumed for steps not laid out yet, until one has been measured */
+#define ESTIMATED_CELL_WIDTH  60
+#define ESTIMATED_CELL_HEIGHT 45
+
+/* Drawing works on any cairo_t: the GTK drawing area, or image / SVG / PDF surfaces */
+
+// Draw a single matrix with layout (from step_layout_create()); returns total width
+// in pixels for layout purposes. With cache set its text is recorded for redraws.
+int draw_matrix(cairo_t *cr, PangoLayout *layout, MatrixStep *step,
+                int start_x, int start_y, gboolean cache, int *out_height);
+// Draw a matrix as a magnitude / zero-pattern heatmap; same contract as draw_matrix
+int draw_matrix_heatmap(cairo_t *cr, MatrixStep *step, int start_x, int start_y, int *out_height);
+void draw_arrow(cairo_t *cr, double x1, double y1,
+                double x2, double y2, double head_size);
+
+// Draw all steps left to right, wrapping after a matrix once past wrap_width (0 = never).
+// With page_height > 0, no line crosses a multiple of page_height (given it fits a page).
+// Operation labels are formatted on first draw and skipped unless show_labels is set.
+// Steps past the clip that are not laid out yet are sized by estimate, not laid out.
+// With cache_text set, visible steps keep their shaped text for the next redraw
+// (for repeated drawing such as the GUI; steps outside the clip drop it).
+// Returns the full drawing size, margins included, via out_width / out_height.
+void draw_steps(cairo_t *cr, StepList *list, gboolean show_text, gboolean show_labels,
+                gboolean cache_text, int wrap_width, int page_height,
+                int *out_width, int *out_height);
+
+#endif // RENDER_H_INCLUDED
@@ -0,0 +1,66 @@
+#ifndef RREF_SERVICE_H_INCLUDED
+#define RREF_SERVICE_H_INCLUDED
+
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+ * Local solver service protocol (Unix domain socket, native byte order).
+ *
+ * Request:  ServiceRequest, then rows*cols doubles (row-major)
+ * Response: ServiceResponse, then rows*cols doubles of the RREF,
+ *           rank uint32 pivot columns, steps_size bytes of step log
+ *           (one operation label per line) if SERVICE_WANT_STEPS was set
+ *
+ * A connection may pipeline requests; responses carry the request id and
+ * can arrive out of order.
+ */
+
+#define SERVICE_MAGIC      0x46455252u  // "RREF"
+#define SERVICE_MAX_DIM    256
+#define SERVICE_WANT_STEPS 0x1u
+#define SERVICE_MIXED      0x2u  // float elimination + refinement; ignored with WANT_STEPS
+
+#define SERVICE_OK          0
+#define SERVICE_ERR_SIZE   -1   // rows/cols out of range
+
+typedef struct {
+    uint32_t magic;
+    uint32_t id;
+    uint32_t flags;
+    uint32_t rows;
+    uint32_t cols;
+} ServiceRequest;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t id;
+    int32_t status;
+    uint32_t rows;
+    uint32_t cols;
+    uint32_t rank;
+    uint32_t steps_size;
+} ServiceResponse;
+
+typedef struct {
+    ServiceResponse header;
+    double *matrix;      // rows*cols
+    uint32_t *pivots;    // rank entries
+    char *steps;         // NUL-terminated, NULL if not requested
+} ServiceResult;
+
+// Blocking I/O on a socket; return 0 on success, -1 on error or EOF
+int service_read_full(int fd, void *buf, size_t len);
+int service_write_full(int fd, const void *buf, size_t len);
+
+// Connect to the service socket; returns fd or -1 (errno set)
+int service_connect(const char *path);
+
+int service_send_request(int fd, uint32_t id, uint32_t flags,
+                         int rows, int cols, const double *values);
+
+// Read one response into result; free it with service_free_result
+int service_read_result(int fd, ServiceResult *result);
+void service_free_result(ServiceResult *result);
+
+#endif // RREF_SERVICE_H_INCLUDED
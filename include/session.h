@@ -0,0 +1,71 @@
+#ifndef SESSION_H_INCLUDED
+#define SESSION_H_INCLUDED
+
+#include "gui.h"
+#include <stdint.h>
+
+/*
+ * Binary session file: the input matrix plus the full step log of a solve.
+ *
+ * Layout (native byte order, checked via byte_order on load):
+ *   SessionHeader
+ *   SessionStep[step_count]   (SessionStepV1 in version 1 files)
+ *   double cells[]      row-major values of every matrix step, 8-byte aligned
+ *   char   strings[]    NUL-terminated arrow labels (string table)
+ *
+ * The first matrix step is the input matrix. The file is mmap'd on load and
+ * the steps point straight into the mapping, so nothing is re-solved or copied.
+ * Version 2 adds the RowOp of each arrow step, so labels left out of the
+ * string table can still be formatted after loading.
+ */
+
+#define SESSION_MAGIC      "RREFSESS"
+#define SESSION_VERSION    2
+#define SESSION_BYTE_ORDER 0x01020304u
+#define SESSION_NO_LABEL   UINT64_MAX
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint32_t step_count;
+    uint32_t reserved;
+    uint64_t steps_offset;
+    uint64_t cells_offset;
+    uint64_t cells_count;
+    uint64_t strings_offset;
+    uint64_t strings_size;
+    uint64_t file_size;
+} SessionHeader;
+
+typedef struct {
+    uint32_t rows;    // 0 for an arrow step
+    uint32_t cols;
+    uint64_t offset;  // matrix: index into cells, arrow: offset into strings
+} SessionStepV1;
+
+typedef struct {
+    uint32_t rows;    // 0 for an arrow step
+    uint32_t cols;
+    uint64_t offset;  // matrix: index into cells, arrow: offset into strings
+    uint32_t op_type; // RowOpType of an arrow step
+    int32_t op_dest;
+    int32_t op_src;
+    uint32_t reserved;
+    double op_coeff;
+} SessionStep;
+
+// Write all steps to path, with the arrow labels only if with_labels is set.
+// Returns 0 on success, -1 with errno set on failure
+int session_save(StepList *list, const char *path, int with_labels);
+
+// Map path and point list at it; list must be empty. Returns 0 or -1 (errno set)
+int session_load(StepList *list, const char *path);
+
+// Unmap a list filled by session_load (called through free_step_list)
+void session_release(StepList *list);
+
+// Whether ptr points into the mapping behind list (and must not be freed)
+int session_owns(const StepList *list, const void *ptr);
+
+#endif // SESSION_H_INCLUDED
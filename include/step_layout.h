@@ -0,0 +1,35 @@
+#ifndef STEP_LAYOUT_H_INCLUDED
+#define STEP_LAYOUT_H_INCLUDED
+
+#include "gui.h"
+
+#define CELL_FONT    "Sans 18"
+#define ARROW_FONT   "Sans 16"
+#define CELL_PADDING 20     // added to every column width and row height
+
+#define LAYOUT_MIN_PARALLEL_CELLS 4096  // below this, lay out on the calling thread
+#define LAYOUT_CHUNKS_PER_THREAD  4
+#define LAYOUT_RESOLUTION         96.0  // dpi used for measuring and drawing
+
+/*
+ * Extents are measured once and then drawn at any zoom, device scale or
+ * output surface, so measuring and drawing share one configuration:
+ * unhinted metrics, unrounded glyph positions and a fixed resolution.
+ */
+
+// Apply the shared font options and resolution to context
+void step_layout_configure(PangoContext *context);
+
+// Layout for drawing on cr, configured like the precompute workers
+PangoLayout *step_layout_create(cairo_t *cr);
+
+// Format and measure one step into its display cache (no-op if already laid out).
+// layout may be any PangoLayout; its font is set per step kind.
+void layout_step(PangoLayout *layout, MatrixStep *step);
+
+// Lay out every step of list on the shared worker pool; returns once all are done.
+// Arrow labels are only formatted and measured when with_labels is set.
+// Safe to call from several threads at once.
+void precompute_step_layouts(StepList *list, int with_labels);
+
+#endif // STEP_LAYOUT_H_INCLUDED
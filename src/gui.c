@@ -2,6 +2,9 @@
 #include "gui.h"
 #include "matrix_operations.h"
 #include "r-ref.h"
+#include "session.h"
+#include "step_layout.h"
+#include "render.h"
 #include <pango/pangocairo.h>
 #include <stdlib.h>
 #include <string.h>
@@ -95,16 +98,7 @@ void render_matrix(GtkButton *btn, gpointer user_data) {
     }
 
     // Clear previous steps
-    for (int s = 0; s < app->step_list.count; s++) {
-        MatrixStep step = app->step_list.steps[s];
-        if (step.matrix) {
-            for (int i = 0; i < step.rows; i++) free(step.matrix[i]);
-            free(step.matrix);
-        }
-    }
-    free(app->step_list.steps);
-    app->step_list.steps = NULL;
-    app->step_list.count = 0;
+    free_step_list(&app->step_list);
 
     // Record initial matrix as first step (contiguous array)
     double (*temp)[app->cols] = malloc(sizeof(double[app->rows][app->cols]));
@@ -114,6 +108,7 @@ void render_matrix(GtkButton *btn, gpointer user_data) {
 
     record_step(app, app->rows, app->cols, temp);
     free(temp);
+    precompute_step_layouts(&app->step_list, app->show_labels);
 
     gtk_widget_queue_draw(app->drawing_area);
 }
@@ -125,17 +120,7 @@ void render_rref_matrix(GtkButton *btn, gpointer user_data) {
     if (!app->matrix_entries) return;
 
     // Clear previous steps
-    for (int i = 0; i < app->step_list.count; i++) {
-        MatrixStep s = app->step_list.steps[i];
-        if (s.matrix) {
-            for (int j = 0; j < s.rows; j++)
-                free(s.matrix[j]);
-            free(s.matrix);
-        }
-    }
-    free(app->step_list.steps);
-    app->step_list.steps = NULL;
-    app->step_list.count = 0;
+    free_step_list(&app->step_list);
 
     int rows = app->rows;
     int cols = app->cols;
@@ -149,6 +134,7 @@ void render_rref_matrix(GtkButton *btn, gpointer user_data) {
     // **Do not record the initial step here**
     // rref() will record it internally once at start
     rref(app, rows, cols, M);
+    precompute_step_layouts(&app->step_list, app->show_labels);
 
     gtk_widget_queue_draw(app->drawing_area);
 }
@@ -156,136 +142,51 @@ void render_rref_matrix(GtkButton *btn, gpointer user_data) {
 
 
 
-/* ------------------------------ Draw Arrows ----------------------------- */
-void draw_arrow(cairo_t *cr, double x1, double y1,
-                double x2, double y2, double head_size)
-{
-    double angle = atan2(y2 - y1, x2 - x1);
-
-    /* Draw shaft */
-    cairo_move_to(cr, x1, y1);
-    cairo_line_to(cr, x2, y2);
-    cairo_stroke(cr);
-
-    /* Draw arrowhead */
-    cairo_move_to(cr, x2, y2);
-    cairo_line_to(cr, x2 - head_size * cos(angle - M_PI/6),
-                         y2 - head_size * sin(angle - M_PI/6));
-    cairo_line_to(cr, x2 - head_size * cos(angle + M_PI/6),
-                         y2 - head_size * sin(angle + M_PI/6));
-    cairo_close_path(cr);
-    cairo_fill(cr);
-}
+/* ------------------ Save / load step history ------------------ */
+void save_session_clicked(GtkButton *btn, gpointer user_data) {
+    AppData *app = user_data;
+    const char *path = gtk_editable_get_text(GTK_EDITABLE(app->session_entry));
+    if (!app->step_list.steps || !path[0]) return;
 
+    if (session_save(&app->step_list, path, app->show_labels) != 0)
+        g_warning("Could not save session to %s: %s", path, g_strerror(errno));
+}
 
+void load_session_clicked(GtkButton *btn, gpointer user_data) {
+    AppData *app = user_data;
+    const char *path = gtk_editable_get_text(GTK_EDITABLE(app->session_entry));
+    if (!path[0]) return;
 
-/* ------------------ 6. Draw function for GtkDrawingArea ------------------ */
-// Returns width and sets height via pointer
-int draw_matrix(cairo_t *cr, MatrixStep *step, int start_x, int start_y, int *out_height) {
-    if (!step->matrix) {
-        if (out_height) *out_height = 0;
-        return 0;
+    StepList loaded = {0};
+    if (session_load(&loaded, path) != 0) {
+        g_warning("Could not load session from %s: %s", path, g_strerror(errno));
+        return;
     }
-
-    PangoLayout *layout = pango_cairo_create_layout(cr);
-    PangoFontDescription *desc = pango_font_description_from_string("Sans 18");
-    pango_layout_set_font_description(layout, desc);
-
-    int rows = step->rows;
-    int cols = step->cols;
-
-    /* ---------------- Measure column widths ---------------- */
-    int *col_width = malloc(cols * sizeof(int));
-    for (int j = 0; j < cols; j++) col_width[j] = 0;
-
-    for (int i = 0; i < rows; i++)
-        for (int j = 0; j < cols; j++) {
-            char buffer[64];
-            format_for_step(step->matrix[i][j], buffer, sizeof(buffer));
-            pango_layout_set_text(layout, buffer, -1);
-            int tw, th;
-            pango_layout_get_pixel_size(layout, &tw, &th);
-            if (tw > col_width[j]) col_width[j] = tw;
-        }
-
-    for (int j = 0; j < cols; j++) col_width[j] += 20; // horizontal padding
-
-    /* ---------------- Measure row heights ---------------- */
-    int *row_height = malloc(rows * sizeof(int));
-    for (int i = 0; i < rows; i++) row_height[i] = 0;
-
-    for (int i = 0; i < rows; i++)
-        for (int j = 0; j < cols; j++) {
-            char buffer[64];
-            format_for_step(step->matrix[i][j], buffer, sizeof(buffer));
-            pango_layout_set_text(layout, buffer, -1);
-            int tw, th;
-            pango_layout_get_pixel_size(layout, &tw, &th);
-            if (th > row_height[i]) row_height[i] = th;
-        }
-
-    for (int i = 0; i < rows; i++) row_height[i] += 20; // vertical padding
-
-    /* ---------------- Compute total matrix size ---------------- */
-    int matrix_w = 0, matrix_h = 0;
-    for (int j = 0; j < cols; j++) matrix_w += col_width[j];
-    for (int i = 0; i < rows; i++) matrix_h += row_height[i];
-
-    double pad = 10; // bracket padding
-    if (out_height) *out_height = matrix_h + 2 * pad;
-
-    /* ---------------- Draw brackets ---------------- */
-    double left_x = start_x - pad;
-    double top_y = start_y - pad;
-    double bottom_y = start_y + matrix_h + pad;
-    double right_x = start_x + matrix_w + pad;
-
-    cairo_set_line_width(cr, 3);
-    cairo_set_source_rgb(cr, 0, 0, 0);
-
-    /* Left bracket */
-    cairo_move_to(cr, left_x + pad, top_y);
-    cairo_line_to(cr, left_x, top_y);
-    cairo_line_to(cr, left_x, bottom_y);
-    cairo_line_to(cr, left_x + pad, bottom_y);
-    cairo_stroke(cr);
-
-    /* Right bracket */
-    cairo_move_to(cr, right_x - pad, top_y);
-    cairo_line_to(cr, right_x, top_y);
-    cairo_line_to(cr, right_x, bottom_y);
-    cairo_line_to(cr, right_x - pad, bottom_y);
-    cairo_stroke(cr);
-
-    /* ---------------- Draw numbers ---------------- */
-    int current_x = start_x;
-    for (int j = 0; j < cols; j++) {
-        int current_y = start_y;
-        for (int i = 0; i < rows; i++) {
-            char buffer[64];
-            format_for_step(step->matrix[i][j], buffer, sizeof(buffer));
-
-            pango_layout_set_text(layout, buffer, -1);
-            int tw, th;
-            pango_layout_get_pixel_size(layout, &tw, &th);
-
-            double cx = current_x + col_width[j] / 2.0;
-            double cy = current_y + row_height[i] / 2.0;
-
-            cairo_move_to(cr, cx - tw / 2.0, cy - th / 2.0);
-            pango_cairo_show_layout(cr, layout);
-
-            current_y += row_height[i];
-        }
-        current_x += col_width[j];
+    free_step_list(&app->step_list);
+    app->step_list = loaded;
+    // No precompute: draw_steps() lays out steps as they scroll into view
+
+    // Refill the input grid from the first (input) matrix
+    MatrixStep *input = NULL;
+    for (int s = 0; s < loaded.count && !input; s++)
+        if (loaded.steps[s].matrix) input = &loaded.steps[s];
+
+    if (input) {
+        char buffer[64];
+        snprintf(buffer, sizeof(buffer), "%d", input->rows);
+        gtk_editable_set_text(GTK_EDITABLE(app->rows_entry), buffer);
+        snprintf(buffer, sizeof(buffer), "%d", input->cols);
+        gtk_editable_set_text(GTK_EDITABLE(app->cols_entry), buffer);
+        create_matrix(NULL, app);
+
+        for (int i = 0; i < input->rows; i++)
+            for (int j = 0; j < input->cols; j++) {
+                snprintf(buffer, sizeof(buffer), "%.17g", input->matrix[i][j]);
+                gtk_editable_set_text(GTK_EDITABLE(app->matrix_entries[i][j]), buffer);
+            }
     }
 
-    free(col_width);
-    free(row_height);
-    g_object_unref(layout);
-    pango_font_description_free(desc);
-
-    return matrix_w + 2 * pad; // include bracket padding
+    gtk_widget_queue_draw(app->drawing_area);
 }
 
 
@@ -301,114 +202,77 @@ void draw_func(GtkDrawingArea *area, cairo_t *cr,
     cairo_set_source_rgb(cr, 1, 1, 1);
     cairo_paint(cr);
 
-    int start_x = 60;
-    int start_y = 60;
-    int offset_x = start_x;
-    int offset_y = start_y;
-    int row_spacing = 60;
-    int col_spacing = 40;
-
-    int max_row_height = 0;
-    int total_width = start_x;
-    int total_height = start_y;
-
-    int prev_matrix_h = 0;
-
-    for (int s = 0; s < app->step_list.count; s++) {
-        MatrixStep *step = &app->step_list.steps[s];
-
-        int matrix_h = 0;
-        int matrix_w = 0;
-
-        if (step->matrix) {
-            matrix_w = draw_matrix(cr, step, offset_x, offset_y, &matrix_h);
-            prev_matrix_h = matrix_h;
-
-            offset_x += matrix_w + col_spacing;
-            if (matrix_h > max_row_height) max_row_height = matrix_h;
-
-        } else {
-            /* ---------------- Measure arrow text ---------------- */
-            int text_w = 0, text_h = 0;
-
-            if (step->above_arrow) {
-                PangoLayout *layout = pango_cairo_create_layout(cr);
-                PangoFontDescription *desc =
-                        pango_font_description_from_string("Sans 16");
-
-                pango_layout_set_font_description(layout, desc);
-                pango_layout_set_text(layout, step->above_arrow, -1);
-                pango_layout_get_pixel_size(layout, &text_w, &text_h);
-
-                g_object_unref(layout);
-                pango_font_description_free(desc);
-            }
-
-            /* ---------------- Compute arrow block width ---------------- */
-            int min_arrow_width = 80;
-            int padding = 40;
-
-            int arrow_block_width =
-                (text_w + padding > min_arrow_width)
-                ? text_w + padding
-                : min_arrow_width;
-
-            double arrow_start_x = offset_x;
-            double arrow_end_x   = offset_x + arrow_block_width;
-            double arrow_mid_y   = offset_y + prev_matrix_h / 2.0;
-
-            /* ---------------- Draw Arrow ---------------- */
-            draw_arrow(cr,
-                       arrow_start_x,
-                       arrow_mid_y,
-                       arrow_end_x,
-                       arrow_mid_y,
-                       12);
-
-            /* ---------------- Draw Centered Text ---------------- */
-            if (step->above_arrow) {
+    /* Clip to the part the scrolled window shows so off-screen steps are skipped */
+    GtkWidget *viewport = gtk_scrolled_window_get_child(GTK_SCROLLED_WINDOW(app->draw_scrolled));
+    graphene_rect_t bounds;
+    if (viewport && gtk_widget_compute_bounds(GTK_WIDGET(area), viewport, &bounds)) {
+        cairo_rectangle(cr, -bounds.origin.x, -bounds.origin.y,
+                        gtk_widget_get_width(viewport), gtk_widget_get_height(viewport));
+        cairo_clip(cr);
+    }
 
-                PangoLayout *layout = pango_cairo_create_layout(cr);
-                PangoFontDescription *desc =
-                        pango_font_description_from_string("Sans 16");
+    /* Zoom: text only once cells are legible, heatmaps below that */
+    double zoom = app->zoom > 0 ? app->zoom : 1.0;
+    cairo_scale(cr, zoom, zoom);
 
-                pango_layout_set_font_description(layout, desc);
-                pango_layout_set_text(layout, step->above_arrow, -1);
+    int total_width, total_height;
+    draw_steps(cr, &app->step_list, zoom >= LOD_TEXT_ZOOM, app->show_labels, TRUE, 0, 0,
+               &total_width, &total_height);
 
-                double text_x =
-                    arrow_start_x +
-                    (arrow_block_width / 2.0) -
-                    (text_w / 2.0);
+    gtk_widget_set_size_request(GTK_WIDGET(app->drawing_area),
+                                total_width * zoom,
+                                total_height * zoom);
+}
 
-                double text_y =
-                    arrow_mid_y - text_h - 15;
+// Drawing is clipped to the visible area, so scrolling and resizing must repaint
+static void visible_area_changed(GtkAdjustment *adjustment, gpointer user_data) {
+    AppData *app = user_data;
+    gtk_widget_queue_draw(app->drawing_area);
+}
 
-                cairo_move_to(cr, text_x, text_y);
-                cairo_set_source_rgb(cr, 0, 0, 0);
-                pango_cairo_show_layout(cr, layout);
+/* ------------------ Zoom controls ------------------ */
+static void set_zoom(AppData *app, double zoom) {
+    if (zoom < ZOOM_MIN) zoom = ZOOM_MIN;
+    if (zoom > ZOOM_MAX) zoom = ZOOM_MAX;
+    app->zoom = zoom;
+    gtk_widget_queue_draw(app->drawing_area);
+}
 
-                g_object_unref(layout);
-                pango_font_description_free(desc);
-            }
+void zoom_in_clicked(GtkButton *btn, gpointer user_data) {
+    AppData *app = user_data;
+    set_zoom(app, app->zoom * ZOOM_STEP);
+}
 
-            offset_x += arrow_block_width + col_spacing;
-        }
+void zoom_out_clicked(GtkButton *btn, gpointer user_data) {
+    AppData *app = user_data;
+    set_zoom(app, app->zoom / ZOOM_STEP);
+}
 
-        if (offset_y + max_row_height > total_height)
-            total_height = offset_y + max_row_height;
+// Ctrl + scroll wheel zooms, plain scrolling is left to the scrolled window
+static gboolean zoom_scroll(GtkEventControllerScroll *controller,
+                            double dx, double dy, gpointer user_data)
+{
+    AppData *app = user_data;
+    GdkModifierType state =
+        gtk_event_controller_get_current_event_state(GTK_EVENT_CONTROLLER(controller));
+    if (!(state & GDK_CONTROL_MASK) || dy == 0) return FALSE;
 
-        if (offset_x > total_width)
-            total_width = offset_x;
-    }
+    set_zoom(app, dy < 0 ? app->zoom * ZOOM_STEP : app->zoom / ZOOM_STEP);
+    return TRUE;
+}
 
-    gtk_widget_set_size_request(GTK_WIDGET(app->drawing_area),
-                                total_width + 60,
-                                total_height + 60);
+/* ------------------ Operation labels on / off ------------------ */
+void labels_toggled(GtkCheckButton *check, gpointer user_data) {
+    AppData *app = user_data;
+    app->show_labels = gtk_check_button_get_active(check);
+    gtk_widget_queue_draw(app->drawing_area);
 }
 
 /* ------------------ Activate function ------------------ */
 void activate(GtkApplication *app, gpointer user_data) {
     AppData *data = g_malloc0(sizeof(AppData));
+    data->zoom = 1.0;
+    data->show_labels = TRUE;
 
     GtkWidget *window = gtk_application_window_new(app);
     gtk_window_set_title(GTK_WINDOW(window), "Matrix Input + Renderer");
@@ -429,15 +293,35 @@ void activate(GtkApplication *app, gpointer user_data) {
     GtkWidget *render_btn = gtk_button_new_with_label("Render Matrix");
     GtkWidget *rref_btn = gtk_button_new_with_label("RREF");
 
+    data->session_entry = gtk_entry_new();
+    gtk_entry_set_placeholder_text(GTK_ENTRY(data->session_entry), "Session file");
+    GtkWidget *save_btn = gtk_button_new_with_label("Save Session");
+    GtkWidget *load_btn = gtk_button_new_with_label("Load Session");
+    GtkWidget *zoom_out_btn = gtk_button_new_with_label("Zoom -");
+    GtkWidget *zoom_in_btn = gtk_button_new_with_label("Zoom +");
+    GtkWidget *labels_check = gtk_check_button_new_with_label("Labels");
+    gtk_check_button_set_active(GTK_CHECK_BUTTON(labels_check), TRUE);
+
     g_signal_connect(create_btn, "clicked", G_CALLBACK(create_matrix), data);
     g_signal_connect(render_btn, "clicked", G_CALLBACK(render_matrix), data);
     g_signal_connect(rref_btn, "clicked", G_CALLBACK(render_rref_matrix), data);
+    g_signal_connect(save_btn, "clicked", G_CALLBACK(save_session_clicked), data);
+    g_signal_connect(load_btn, "clicked", G_CALLBACK(load_session_clicked), data);
+    g_signal_connect(zoom_out_btn, "clicked", G_CALLBACK(zoom_out_clicked), data);
+    g_signal_connect(zoom_in_btn, "clicked", G_CALLBACK(zoom_in_clicked), data);
+    g_signal_connect(labels_check, "toggled", G_CALLBACK(labels_toggled), data);
 
     gtk_box_append(GTK_BOX(controls), data->rows_entry);
     gtk_box_append(GTK_BOX(controls), data->cols_entry);
     gtk_box_append(GTK_BOX(controls), create_btn);
     gtk_box_append(GTK_BOX(controls), render_btn);
     gtk_box_append(GTK_BOX(controls), rref_btn);
+    gtk_box_append(GTK_BOX(controls), data->session_entry);
+    gtk_box_append(GTK_BOX(controls), save_btn);
+    gtk_box_append(GTK_BOX(controls), load_btn);
+    gtk_box_append(GTK_BOX(controls), zoom_out_btn);
+    gtk_box_append(GTK_BOX(controls), zoom_in_btn);
+    gtk_box_append(GTK_BOX(controls), labels_check);
 
     /* ---------------- Input grid with scroll ---------------- */
     data->grid = gtk_grid_new();
@@ -463,6 +347,11 @@ void activate(GtkApplication *app, gpointer user_data) {
     gtk_widget_set_hexpand(data->drawing_area, FALSE);
     gtk_widget_set_vexpand(data->drawing_area, FALSE);
 
+    GtkEventController *scroll =
+        gtk_event_controller_scroll_new(GTK_EVENT_CONTROLLER_SCROLL_VERTICAL);
+    g_signal_connect(scroll, "scroll", G_CALLBACK(zoom_scroll), data);
+    gtk_widget_add_controller(data->drawing_area, scroll);
+
     GtkWidget *draw_frame = gtk_frame_new("Rendered Output");
     gtk_frame_set_child(GTK_FRAME(draw_frame), data->drawing_area);
 
@@ -472,6 +361,16 @@ void activate(GtkApplication *app, gpointer user_data) {
     gtk_scrolled_window_set_child(GTK_SCROLLED_WINDOW(draw_scrolled), draw_frame);
     gtk_widget_set_hexpand(draw_scrolled, TRUE);
     gtk_widget_set_vexpand(draw_scrolled, TRUE);
+    data->draw_scrolled = draw_scrolled;
+
+    GtkAdjustment *adjustments[] = {
+        gtk_scrolled_window_get_hadjustment(GTK_SCROLLED_WINDOW(draw_scrolled)),
+        gtk_scrolled_window_get_vadjustment(GTK_SCROLLED_WINDOW(draw_scrolled)),
+    };
+    for (int k = 0; k < 2; k++) {
+        g_signal_connect(adjustments[k], "value-changed", G_CALLBACK(visible_area_changed), data);
+        g_signal_connect(adjustments[k], "changed", G_CALLBACK(visible_area_changed), data);
+    }
 
     /* ---------------- Horizontal content box ---------------- */
     GtkWidget *content_box = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 20);
@@ -1,6 +1,8 @@
 #include "matrix_operations.h"
+#include "session.h"
 #include <string.h>
 #include <errno.h>
+#include <float.h>
 
 /* ---------------- Row operations ---------------- */
 void swap_rows(int r, int c, double M[r][c], int i, int j) {
@@ -20,10 +22,10 @@ void add_row(int r, int c, double M[r][c], double k, int src, int dest) {
         M[dest][n] += k * M[src][n];
 }
 
-void clean_matrix(int r, int c, double M[r][c]) {
+void clean_matrix(int r, int c, double M[r][c], double tol) {
     for (int i = 0; i < r; i++)
         for (int j = 0; j < c; j++)
-            if (fabs(M[i][j]) < EPS)
+            if (fabs(M[i][j]) <= tol)
                 M[i][j] = 0.0;
 }
 
@@ -41,11 +43,50 @@ int matrix_changed(int r, int c, double M[r][c], double prev[r][c]) {
     return 0;
 }
 
+// Pivot threshold for rank decisions: max(rows, cols) * machine epsilon * ||M||_inf
+double rank_tolerance(int r, int c, double M[r][c]) {
+    double norm = 0;
+    for (int i = 0; i < r; i++) {
+        double row_sum = 0;
+        for (int j = 0; j < c; j++) row_sum += fabs(M[i][j]);
+        if (row_sum > norm) norm = row_sum;
+    }
+    return (r > c ? r : c) * DBL_EPSILON * norm;
+}
+
+void clean_row(int r, int c, double M[r][c], int row, double tol) {
+    for (int j = 0; j < c; j++)
+        if (fabs(M[row][j]) <= tol)
+            M[row][j] = 0.0;
+}
+
+void copy_row(int r, int c, double M[r][c], double prev[r][c], int row) {
+    memcpy(prev[row], M[row], c * sizeof(double));
+}
+
+int row_changed(int r, int c, double M[r][c], double prev[r][c], int row, double tol) {
+    for (int j = 0; j < c; j++)
+        if (fabs(M[row][j] - prev[row][j]) > tol)
+            return 1;
+    return 0;
+}
+
 /* ---------------- Record matrix steps ---------------- */
+// Append a zeroed step, doubling the allocation when full
+static MatrixStep *append_step(StepList *list) {
+    if (list->count == list->capacity) {
+        list->capacity = list->capacity ? list->capacity * 2 : 16;
+        list->steps = realloc(list->steps, list->capacity * sizeof(MatrixStep));
+    }
+    MatrixStep *step = &list->steps[list->count++];
+    memset(step, 0, sizeof(*step));
+    return step;
+}
+
+// Matrix snapshots are only kept when the list records RECORD_STEPS
 void record_step(AppData *app, int r, int c, double M[r][c]) {
-    app->step_list.steps = realloc(app->step_list.steps,
-                                   (app->step_list.count + 1) * sizeof(MatrixStep));
-    MatrixStep *step = &app->step_list.steps[app->step_list.count];
+    if (app->step_list.recording != RECORD_STEPS) return;
+    MatrixStep *step = append_step(&app->step_list);
     step->rows = r;
     step->cols = c;
     step->matrix = malloc(r * sizeof(double*));
@@ -55,18 +96,74 @@ void record_step(AppData *app, int r, int c, double M[r][c]) {
             step->matrix[i][j] = M[i][j];
     }
     step->above_arrow = NULL;
-    app->step_list.count++;
 }
 
-void record_arrow(AppData *app, const char *text) {
-    app->step_list.steps = realloc(app->step_list.steps,
-                                   (app->step_list.count + 1) * sizeof(MatrixStep));
-    MatrixStep *step = &app->step_list.steps[app->step_list.count];
+// Arrow steps only store the operation; the label is built on first use
+void record_op(AppData *app, RowOpType type, int dest, int src, double coeff) {
+    if (app->step_list.recording == RECORD_NONE) return;
+    MatrixStep *step = append_step(&app->step_list);
     step->matrix = NULL;
     step->rows = 0;
     step->cols = 0;
-    step->above_arrow = text ? strdup(text) : NULL;
-    app->step_list.count++;
+    step->above_arrow = NULL;
+    step->op = (RowOp){ type, dest, src, coeff };
+}
+
+// Label of an arrow step, formatted from its RowOp the first time it is asked for
+const char *step_label(MatrixStep *step) {
+    if (step->above_arrow || step->matrix) return step->above_arrow;
+
+    char op[100], coeff[32];
+    switch (step->op.type) {
+    case OP_SWAP:
+        snprintf(op, sizeof(op), "R%d <-> R%d", step->op.dest + 1, step->op.src + 1);
+        break;
+    case OP_SCALE:
+        format_for_step(step->op.coeff, coeff, sizeof(coeff));
+        snprintf(op, sizeof(op), "R%d -> (%s)R%d", step->op.dest + 1, coeff, step->op.dest + 1);
+        break;
+    case OP_ADD:
+        format_for_step(step->op.coeff, coeff, sizeof(coeff));
+        snprintf(op, sizeof(op), "R%d -> R%d + (%s)R%d",
+                 step->op.dest + 1, step->op.dest + 1, coeff, step->op.src + 1);
+        break;
+    default:
+        return NULL;
+    }
+    step->above_arrow = strdup(op);
+    return step->above_arrow;
+}
+
+void free_step_list(StepList *list) {
+    for (int s = 0; s < list->count; s++) {
+        MatrixStep *step = &list->steps[s];
+        free(step->cell_text);
+        free(step->cell_offset);
+        free(step->cell_width);
+        free(step->col_width);
+        free(step->row_height);
+        if (step->text_cache) list->free_text_cache(step->text_cache);
+        if (list->mapping && !session_owns(list, step->above_arrow)) {
+            free(step->above_arrow);  // formatted after load, not from the string table
+            step->above_arrow = NULL;
+        }
+    }
+    if (list->mapping) {
+        session_release(list);
+        return;
+    }
+    for (int s = 0; s < list->count; s++) {
+        MatrixStep *step = &list->steps[s];
+        if (step->matrix) {
+            for (int i = 0; i < step->rows; i++) free(step->matrix[i]);
+            free(step->matrix);
+        }
+        free(step->above_arrow);
+    }
+    free(list->steps);
+    list->steps = NULL;
+    list->count = 0;
+    list->capacity = 0;
 }
 
 /* ---------------- Utilities ---------------- */
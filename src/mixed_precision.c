@@ -0,0 +1,237 @@
+#include "mixed_precision.h"
+#include "matrix_operations.h"
+#include <stdlib.h>
+#include <string.h>
+#include <float.h>
+#include <math.h>
+
+#if defined(__AVX__) || defined(__SSE__)
+#include <immintrin.h>
+#endif
+
+/* ---------------- Float kernels ---------------- */
+// y -= a * x, 8 (AVX) or 4 (SSE) floats per instruction
+static void saxpy_sub(int n, float a, const float *restrict x, float *restrict y) {
+    int i = 0;
+#if defined(__AVX__)
+    __m256 va = _mm256_set1_ps(a);
+    for (; i + 8 <= n; i += 8)
+        _mm256_storeu_ps(y + i, _mm256_sub_ps(_mm256_loadu_ps(y + i),
+                                              _mm256_mul_ps(va, _mm256_loadu_ps(x + i))));
+#elif defined(__SSE__)
+    __m128 va = _mm_set1_ps(a);
+    for (; i + 4 <= n; i += 4)
+        _mm_storeu_ps(y + i, _mm_sub_ps(_mm_loadu_ps(y + i),
+                                        _mm_mul_ps(va, _mm_loadu_ps(x + i))));
+#endif
+    for (; i < n; i++)
+        y[i] -= a * x[i];
+}
+
+// In-place LU with partial pivoting of an n x n row-major float matrix.
+// Returns 0, or -1 if a pivot falls below tol (rank deficient).
+static int lu_factor(int n, float *LU, int *perm, float tol) {
+    for (int k = 0; k < n; k++) {
+        int pivot = k;
+        float max_val = fabsf(LU[k * n + k]);
+        for (int i = k + 1; i < n; i++)
+            if (fabsf(LU[i * n + k]) > max_val) { max_val = fabsf(LU[i * n + k]); pivot = i; }
+        if (max_val <= tol) return -1;
+
+        perm[k] = pivot;
+        if (pivot != k)
+            for (int j = 0; j < n; j++) {
+                float tmp = LU[k * n + j]; LU[k * n + j] = LU[pivot * n + j]; LU[pivot * n + j] = tmp;
+            }
+
+        float *row_k = LU + k * n;
+        for (int i = k + 1; i < n; i++) {
+            float *row_i = LU + i * n;
+            float l = row_i[k] / row_k[k];
+            row_i[k] = l;
+            if (l != 0.0f) saxpy_sub(n - k - 1, l, row_k + k + 1, row_i + k + 1);
+        }
+    }
+    return 0;
+}
+
+// Solve (LU) y = r in float, in place
+static void lu_solve(int n, const float *LU, const int *perm, float *y) {
+    for (int k = 0; k < n; k++)
+        if (perm[k] != k) { float tmp = y[k]; y[k] = y[perm[k]]; y[perm[k]] = tmp; }
+    for (int i = 1; i < n; i++) {
+        float sum = y[i];
+        for (int j = 0; j < i; j++) sum -= LU[i * n + j] * y[j];
+        y[i] = sum;
+    }
+    for (int i = n - 1; i >= 0; i--) {
+        float sum = y[i];
+        for (int j = i + 1; j < n; j++) sum -= LU[i * n + j] * y[j];
+        y[i] = sum / LU[i * n + i];
+    }
+}
+
+static double norm_inf_vec(int n, const double *v) {
+    double m = 0;
+    for (int i = 0; i < n; i++) if (fabs(v[i]) > m) m = fabs(v[i]);
+    return m;
+}
+
+/* ---------------- Square solve with refinement ---------------- */
+// Solve K z = rhs for an n x n double matrix K (row-major)
+static int solve_refined(int n, const double *K, const double *rhs, double *z) {
+    float *LU = malloc((size_t)n * n * sizeof(float));
+    int *perm = malloc(n * sizeof(int));
+    float *work = malloc(n * sizeof(float));
+    double *r = malloc(n * sizeof(double));
+
+    double norm_k = 0;
+    for (int i = 0; i < n; i++) {
+        double row_sum = 0;
+        for (int j = 0; j < n; j++) {
+            LU[i * n + j] = (float)K[i * n + j];
+            row_sum += fabs(K[i * n + j]);
+        }
+        if (row_sum > norm_k) norm_k = row_sum;
+    }
+
+    int steps = -1;
+    if (lu_factor(n, LU, perm, n * FLT_EPSILON * (float)norm_k) != 0) goto out;
+
+    for (int i = 0; i < n; i++) work[i] = (float)rhs[i];
+    lu_solve(n, LU, perm, work);
+    for (int i = 0; i < n; i++) z[i] = work[i];
+
+    /* r = rhs - K z in double, correct z with the float factors until the
+       residual is at double rounding level: ||r|| <= sqrt(n) eps ||K|| ||z|| */
+    double prev_update = INFINITY;
+    for (int it = 0; it <= MIXED_MAX_REFINE; it++) {
+        double residual = 0;
+        for (int i = 0; i < n; i++) {
+            double sum = rhs[i];
+            for (int j = 0; j < n; j++) sum -= K[i * n + j] * z[j];
+            r[i] = sum;
+            if (fabs(sum) > residual) residual = fabs(sum);
+        }
+        if (residual <= sqrt(n) * DBL_EPSILON * norm_k * norm_inf_vec(n, z)) { steps = it; break; }
+        if (it == MIXED_MAX_REFINE) break;
+
+        for (int i = 0; i < n; i++) work[i] = (float)r[i];
+        lu_solve(n, LU, perm, work);
+
+        double update = 0;
+        for (int i = 0; i < n; i++) {
+            z[i] += work[i];
+            if (fabs(work[i]) > update) update = fabs(work[i]);
+        }
+        if (update > 0.5 * prev_update) break;   // not contracting: too ill-conditioned for float
+        prev_update = update;
+    }
+
+out:
+    free(LU);
+    free(perm);
+    free(work);
+    free(r);
+    return steps;
+}
+
+/* ---------------- Public entry points ---------------- */
+int solve_mixed(int rows, int cols, double A[rows][cols], const double b[rows], double x[cols]) {
+    if (rows < cols) return -1;
+
+    int n = rows == cols ? cols : rows + cols;
+    double *K = calloc((size_t)n * n, sizeof(double));
+    double *rhs = calloc(n, sizeof(double));
+    double *z = malloc(n * sizeof(double));
+
+    if (rows == cols) {
+        for (int i = 0; i < rows; i++) {
+            memcpy(K + (size_t)i * n, A[i], cols * sizeof(double));
+            rhs[i] = b[i];
+        }
+    } else {
+        /* [I A; A^T 0] [r; x] = [b; 0] */
+        for (int i = 0; i < rows; i++) {
+            K[(size_t)i * n + i] = 1.0;
+            for (int j = 0; j < cols; j++) {
+                K[(size_t)i * n + rows + j] = A[i][j];
+                K[(size_t)(rows + j) * n + i] = A[i][j];
+            }
+            rhs[i] = b[i];
+        }
+    }
+
+    int steps = solve_refined(n, K, rhs, z);
+    if (steps >= 0)
+        memcpy(x, rows == cols ? z : z + rows, cols * sizeof(double));
+
+    free(K);
+    free(rhs);
+    free(z);
+    return steps;
+}
+
+int rref_mixed(int rows, int cols, double M[rows][cols]) {
+    int n = cols - 1;   // unknowns; last column is b
+    if (n < 1 || rows < n) return 0;
+
+    double (*A)[n] = malloc(sizeof(double[rows][n]));
+    double *b = malloc(rows * sizeof(double));
+    double *x = malloc(n * sizeof(double));
+    for (int i = 0; i < rows; i++) {
+        memcpy(A[i], M[i], n * sizeof(double));
+        b[i] = M[i][n];
+    }
+
+    int used = solve_mixed(rows, n, A, b, x) >= 0;
+    int consistent = 0;
+    if (used) {
+        /* ||K|| of the system solve_mixed() refined: A, or [I A; A^T 0] */
+        double residual = 0, norm_b = 0, norm_k = 0;
+        for (int i = 0; i < rows; i++) {
+            double sum = b[i], row_sum = rows == n ? 0 : 1;
+            for (int j = 0; j < n; j++) {
+                sum -= A[i][j] * x[j];
+                row_sum += fabs(A[i][j]);
+            }
+            if (fabs(sum) > residual) residual = fabs(sum);
+            if (fabs(b[i]) > norm_b) norm_b = fabs(b[i]);
+            if (row_sum > norm_k) norm_k = row_sum;
+        }
+        for (int j = 0; rows != n && j < n; j++) {
+            double col_sum = 0;
+            for (int i = 0; i < rows; i++) col_sum += fabs(A[i][j]);
+            if (col_sum > norm_k) norm_k = col_sum;
+        }
+
+        /* Refinement stops at the converged bound below. x of a consistent system
+           can leave up to about cond(K) times that, and the float factors only
+           converge for cond(K) < 1/FLT_EPSILON. A residual between the two bounds
+           cannot tell consistent from not, so leave M to rref(). Square A cannot
+           be inconsistent: past the ceiling x is distrusted instead */
+        int size_k = rows == n ? n : rows + n;
+        double converged = sqrt(size_k) * DBL_EPSILON * (norm_k * norm_inf_vec(n, x) + norm_b);
+        double ceiling = converged / FLT_EPSILON;
+        if (residual <= converged || (rows == n && residual <= ceiling)) consistent = 1;
+        else if (rows == n || residual <= ceiling) used = 0;
+    }
+
+    if (used) {
+        /* [I x; 0 0] when consistent, [I 0; 0 1; 0 0] otherwise */
+        for (int i = 0; i < rows; i++)
+            for (int j = 0; j < cols; j++)
+                M[i][j] = 0.0;
+        for (int i = 0; i < n; i++) {
+            M[i][i] = 1.0;
+            if (consistent) M[i][n] = x[i];
+        }
+        if (!consistent) M[n][n] = 1.0;
+        clean_matrix(rows, cols, M, rank_tolerance(rows, cols, M));
+    }
+
+    free(A);
+    free(b);
+    free(x);
+    return used;
+}
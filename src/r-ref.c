@@ -3,11 +3,33 @@
 #include <stdio.h>
 #include <math.h>
 
+/* ---------------- Step recording ---------------- */
+// An operation only changes row dest (and src for a swap): clean those rows at
+// tol, their noise level, then record the operation if they moved since the
+// last recorded step
+static void finish_op(AppData *app, int rows, int cols, double M[rows][cols],
+                      double prev[rows][cols], double tol,
+                      RowOpType type, int dest, int src, double coeff) {
+    clean_row(rows, cols, M, dest, tol);
+    if (type == OP_SWAP) clean_row(rows, cols, M, src, tol);
+    if (app->step_list.recording == RECORD_NONE) return;
+
+    if (!row_changed(rows, cols, M, prev, dest, tol) &&
+        !(type == OP_SWAP && row_changed(rows, cols, M, prev, src, tol)))
+        return;
+    record_op(app, type, dest, src, coeff);
+    record_step(app, rows, cols, M);
+    copy_row(rows, cols, M, prev, dest);
+    if (type == OP_SWAP) copy_row(rows, cols, M, prev, src);
+}
+
 /* ---------------- REF ---------------- */
-void ref(AppData *app, int rows, int cols, double M[rows][cols]) {
+// Forward elimination; tol is the pivot and zero threshold of the original input
+static void ref_with_tolerance(AppData *app, int rows, int cols, double M[rows][cols], double tol) {
+    record_step(app, rows, cols, M);
+    clean_matrix(rows, cols, M, tol);
     double prev[rows][cols];
     copy_matrix(rows, cols, M, prev);
-    record_step(app, rows, cols, M);
 
     int r = 0;
     for (int c = 0; c < cols && r < rows; c++) {
@@ -16,72 +38,63 @@ void ref(AppData *app, int rows, int cols, double M[rows][cols]) {
         for (int i = r+1; i<rows; i++)
             if (fabs(M[i][c]) > max_val) { max_val = fabs(M[i][c]); pivot = i; }
 
-        if (max_val < EPS) continue;
+        if (max_val <= tol) {
+            /* No pivot here: what is left below row r is rounding residue */
+            for (int i = r; i < rows; i++) M[i][c] = prev[i][c] = 0.0;
+            continue;
+        }
 
         if (pivot != r) {
-            char op[50]; sprintf(op,"R%d <-> R%d", r+1,pivot+1);
-            swap_rows(rows, cols, M, r, pivot); clean_matrix(rows, cols, M);
-            if (matrix_changed(rows, cols, M, prev)) {
-                record_arrow(app, op); record_step(app, rows, cols, M);
-                copy_matrix(rows, cols, M, prev);
-            }
+            swap_rows(rows, cols, M, r, pivot);
+            finish_op(app, rows, cols, M, prev, tol, OP_SWAP, r, pivot, 0.0);
         }
 
         for (int i = r+1;i<rows;i++) {
+            if (fabs(M[i][c]) <= tol) { M[i][c] = prev[i][c] = 0.0; continue; }
             double factor = -M[i][c]/M[r][c];
-            if (fabs(factor) < EPS) continue;
-            char op[100], coeff[32];
-            format_for_step(factor, coeff, sizeof(coeff));
-            sprintf(op,"R%d -> R%d + (%s)R%d", i+1,i+1,coeff,r+1);
-            add_row(rows, cols, M, factor, r, i); clean_matrix(rows, cols, M);
-            if (matrix_changed(rows, cols, M, prev)) {
-                record_arrow(app, op); record_step(app, rows, cols, M);
-                copy_matrix(rows, cols, M, prev);
-            }
+            add_row(rows, cols, M, factor, r, i);
+            M[i][c] = 0.0;  // eliminated exactly, not left as rounding residue
+            finish_op(app, rows, cols, M, prev, tol, OP_ADD, i, r, factor);
         }
         r++;
     }
 }
 
+void ref(AppData *app, int rows, int cols, double M[rows][cols]) {
+    ref_with_tolerance(app, rows, cols, M, rank_tolerance(rows, cols, M));
+}
+
 /* ---------------- RREF ---------------- */
 void rref(AppData *app, int rows, int cols, double M[rows][cols]) {
-    ref(app, rows, cols, M);
+    double tol = rank_tolerance(rows, cols, M);  // from the input, not the reduced matrix
+    ref_with_tolerance(app, rows, cols, M, tol);
     double prev[rows][cols]; copy_matrix(rows, cols, M, prev);
 
     for (int i = rows-1; i>=0; i--) {
         int pivot_col = -1;
-        for (int j=0;j<cols;j++) if(fabs(M[i][j])>EPS) { pivot_col=j; break; }
+        for (int j=0;j<cols;j++) if(fabs(M[i][j])>tol) { pivot_col=j; break; }
         if (pivot_col==-1) continue;
 
         double pivot_val = M[i][pivot_col];
         if (fabs(pivot_val-1.0)>EPS) {
             double scale = 1.0/pivot_val;
-            char op[100], coeff[32];
-            format_for_step(scale, coeff, sizeof(coeff));
-            sprintf(op,"R%d -> (%s)R%d", i+1, coeff, i+1);
-            scale_row(rows, cols, M, scale, i); clean_matrix(rows, cols, M);
-            if (matrix_changed(rows, cols, M, prev)) {
-                record_arrow(app, op); record_step(app, rows, cols, M);
-                copy_matrix(rows, cols, M, prev);
-            }
+            scale_row(rows, cols, M, scale, i);
+            M[i][pivot_col] = 1.0;
+            // The row's rounding noise is scaled with it
+            finish_op(app, rows, cols, M, prev, tol * fabs(scale), OP_SCALE, i, i, scale);
         }
 
         for (int k=0;k<i;k++) {
+            if (fabs(M[k][pivot_col])<=tol) { M[k][pivot_col] = prev[k][pivot_col] = 0.0; continue; }
             double factor=-M[k][pivot_col];
-            if (fabs(factor)<EPS) continue;
-            char op[100], coeff[32];
-            format_for_step(factor, coeff, sizeof(coeff));
-            sprintf(op,"R%d -> R%d + (%s)R%d", k+1, k+1, coeff, i+1);
-            add_row(rows, cols, M, factor, i, k); clean_matrix(rows, cols, M);
-            if (matrix_changed(rows, cols, M, prev)) {
-                record_arrow(app, op); record_step(app, rows, cols, M);
-                copy_matrix(rows, cols, M, prev);
-            }
+            add_row(rows, cols, M, factor, i, k);
+            M[k][pivot_col] = 0.0;
+            finish_op(app, rows, cols, M, prev, tol, OP_ADD, k, i, factor);
         }
     }
 
-    // Remove trailing arrow if exists
-    if (app->step_list.count>0 && app->step_list.steps[app->step_list.count-1].matrix==NULL) {
+    // Remove trailing arrow if exists (an ops-only log is all arrows)
+    if (app->step_list.recording == RECORD_STEPS && app->step_list.count>0 && app->step_list.steps[app->step_list.count-1].matrix==NULL) {
         free(app->step_list.steps[app->step_list.count-1].above_arrow);
         app->step_list.count--;
     }
@@ -0,0 +1,384 @@
+#include "render.h"
+#include "matrix_operations.h"
+#include "step_layout.h"
+#include <pango/pangocairo.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <stdint.h>
+
+
+/* ------------------------------ Draw Arrows ----------------------------- */
+void draw_arrow(cairo_t *cr, double x1, double y1,
+                double x2, double y2, double head_size)
+{
+    double angle = atan2(y2 - y1, x2 - x1);
+
+    /* Draw shaft */
+    cairo_move_to(cr, x1, y1);
+    cairo_line_to(cr, x2, y2);
+    cairo_stroke(cr);
+
+    /* Draw arrowhead */
+    cairo_move_to(cr, x2, y2);
+    cairo_line_to(cr, x2 - head_size * cos(angle - M_PI/6),
+                         y2 - head_size * sin(angle - M_PI/6));
+    cairo_line_to(cr, x2 - head_size * cos(angle + M_PI/6),
+                         y2 - head_size * sin(angle + M_PI/6));
+    cairo_close_path(cr);
+    cairo_fill(cr);
+}
+
+
+
+/* ------------------ Matrix brackets ------------------ */
+// Square brackets around a matrix_w x matrix_h block, pad away from its edges
+static void draw_brackets(cairo_t *cr, int start_x, int start_y,
+                          int matrix_w, int matrix_h, double pad)
+{
+    double left_x = start_x - pad;
+    double top_y = start_y - pad;
+    double bottom_y = start_y + matrix_h + pad;
+    double right_x = start_x + matrix_w + pad;
+
+    cairo_set_line_width(cr, 3);
+    cairo_set_source_rgb(cr, 0, 0, 0);
+
+    /* Left bracket */
+    cairo_move_to(cr, left_x + pad, top_y);
+    cairo_line_to(cr, left_x, top_y);
+    cairo_line_to(cr, left_x, bottom_y);
+    cairo_line_to(cr, left_x + pad, bottom_y);
+    cairo_stroke(cr);
+
+    /* Right bracket */
+    cairo_move_to(cr, right_x - pad, top_y);
+    cairo_line_to(cr, right_x, top_y);
+    cairo_line_to(cr, right_x, bottom_y);
+    cairo_line_to(cr, right_x - pad, bottom_y);
+    cairo_stroke(cr);
+}
+
+// Whether a box lies entirely outside the current clip (the visible area in the GUI)
+static int outside_clip(cairo_t *cr, double x1, double y1, double x2, double y2) {
+    double clip_x1, clip_y1, clip_x2, clip_y2;
+    cairo_clip_extents(cr, &clip_x1, &clip_y1, &clip_x2, &clip_y2);
+    return x1 > clip_x2 || x2 < clip_x1 || y1 > clip_y2 || y2 < clip_y1;
+}
+
+
+/* ------------------ Step text ------------------ */
+// Cells of a matrix step, or the label of an arrow step, with x, y the top left
+static void draw_step_text(cairo_t *cr, PangoLayout *layout, MatrixStep *step, double x, double y) {
+    PangoFontDescription *desc =
+        pango_font_description_from_string(step->matrix ? CELL_FONT : ARROW_FONT);
+    pango_layout_set_font_description(layout, desc);
+    pango_font_description_free(desc);
+    cairo_set_source_rgb(cr, 0, 0, 0);
+
+    if (!step->matrix) {
+        pango_layout_set_text(layout, step->above_arrow, -1);
+        cairo_move_to(cr, x, y);
+        pango_cairo_show_layout(cr, layout);
+        return;
+    }
+
+    int cols = step->cols;
+    double current_x = x;
+    for (int j = 0; j < cols; j++) {
+        double current_y = y;
+        for (int i = 0; i < step->rows; i++) {
+            pango_layout_set_text(layout, step->cell_text + step->cell_offset[i * cols + j], -1);
+            int tw = step->cell_width[i * cols + j];
+            int th = step->row_height[i] - CELL_PADDING;
+
+            double cx = current_x + step->col_width[j] / 2.0;
+            double cy = current_y + step->row_height[i] / 2.0;
+
+            cairo_move_to(cr, cx - tw / 2.0, cy - th / 2.0);
+            pango_cairo_show_layout(cr, layout);
+
+            current_y += step->row_height[i];
+        }
+        current_x += step->col_width[j];
+    }
+}
+
+// Draw step text at x, y. With cache set the shaped glyphs are recorded once,
+// so redraws replay them at any zoom without Pango
+static void show_step_text(cairo_t *cr, PangoLayout *layout, MatrixStep *step,
+                           double x, double y, gboolean cache)
+{
+    if (!step->text_cache && cache) {
+        step->text_cache = cairo_recording_surface_create(CAIRO_CONTENT_COLOR_ALPHA, NULL);
+        cairo_t *record = cairo_create(step->text_cache);
+        draw_step_text(record, layout, step, 0, 0);
+        cairo_destroy(record);
+    }
+
+    if (step->text_cache) {
+        cairo_save(cr);
+        cairo_set_source_surface(cr, step->text_cache, x, y);
+        cairo_paint(cr);
+        cairo_restore(cr);
+    } else {
+        draw_step_text(cr, layout, step, x, y);
+    }
+}
+
+// Steps that leave the visible area give up their recorded text
+static void drop_step_text(MatrixStep *step) {
+    if (!step->text_cache) return;
+    cairo_surface_destroy(step->text_cache);
+    step->text_cache = NULL;
+}
+
+
+/* ------------------ 6. Draw a single matrix ------------------ */
+// Returns width and sets height via pointer
+int draw_matrix(cairo_t *cr, PangoLayout *layout, MatrixStep *step,
+                int start_x, int start_y, gboolean cache, int *out_height)
+{
+    if (!step->matrix) {
+        if (out_height) *out_height = 0;
+        return 0;
+    }
+
+    /* Text and extents normally come precomputed from precompute_step_layouts() */
+    layout_step(layout, step);
+
+    int rows = step->rows;
+    int cols = step->cols;
+
+    /* ---------------- Compute total matrix size ---------------- */
+    int matrix_w = 0, matrix_h = 0;
+    for (int j = 0; j < cols; j++) matrix_w += step->col_width[j];
+    for (int i = 0; i < rows; i++) matrix_h += step->row_height[i];
+
+    double pad = BRACKET_PAD;
+    if (out_height) *out_height = matrix_h + 2 * pad;
+
+    if (outside_clip(cr, start_x - pad, start_y - pad,
+                     start_x + matrix_w + pad, start_y + matrix_h + pad)) {
+        drop_step_text(step);
+        return matrix_w + 2 * pad;
+    }
+
+    /* ---------------- Draw brackets and numbers ---------------- */
+    draw_brackets(cr, start_x, start_y, matrix_w, matrix_h, pad);
+    show_step_text(cr, layout, step, start_x, start_y, cache);
+
+    return matrix_w + 2 * pad; // include bracket padding
+}
+
+
+/* ------------------ Heatmap for zoomed-out steps ------------------ */
+// Writes one pixel per cell straight into an image surface (no text layout),
+// then scales it up with nearest-neighbour filtering
+int draw_matrix_heatmap(cairo_t *cr, MatrixStep *step, int start_x, int start_y, int *out_height) {
+    if (!step->matrix) {
+        if (out_height) *out_height = 0;
+        return 0;
+    }
+
+    int rows = step->rows;
+    int cols = step->cols;
+    int matrix_w = cols * HEATMAP_CELL;
+    int matrix_h = rows * HEATMAP_CELL;
+    double pad = BRACKET_PAD;
+    if (out_height) *out_height = matrix_h + 2 * pad;
+
+    /* Skip steps that are entirely outside the area being repainted */
+    if (outside_clip(cr, start_x - pad, start_y - pad,
+                     start_x + matrix_w + pad, start_y + matrix_h + pad))
+        return matrix_w + 2 * pad;
+
+    double max_abs = 0;
+    for (int i = 0; i < rows; i++)
+        for (int j = 0; j < cols; j++)
+            if (fabs(step->matrix[i][j]) > max_abs) max_abs = fabs(step->matrix[i][j]);
+    double log_max = log1p(max_abs);
+
+    cairo_surface_t *image = cairo_image_surface_create(CAIRO_FORMAT_RGB24, cols, rows);
+    cairo_surface_flush(image);
+    unsigned char *data = cairo_image_surface_get_data(image);
+    int stride = cairo_image_surface_get_stride(image);
+
+    /* Zeros are white; positive cells shade towards blue, negative towards red */
+    for (int i = 0; i < rows; i++) {
+        uint32_t *pixel = (uint32_t *)(data + i * stride);
+        for (int j = 0; j < cols; j++) {
+            double v = step->matrix[i][j];
+            if (fabs(v) < EPS) {
+                pixel[j] = 0xFFFFFF;
+                continue;
+            }
+            double t = log_max > 0 ? log1p(fabs(v)) / log_max : 1.0;
+            uint32_t light = (uint32_t)(220 * (1.0 - t));
+            uint32_t strong = 255 - (uint32_t)(80 * t);
+            pixel[j] = v > 0 ? (light << 16) | (light << 8) | strong
+                             : (strong << 16) | (light << 8) | light;
+        }
+    }
+    cairo_surface_mark_dirty(image);
+
+    cairo_save(cr);
+    cairo_translate(cr, start_x, start_y);
+    cairo_scale(cr, HEATMAP_CELL, HEATMAP_CELL);
+    cairo_set_source_surface(cr, image, 0, 0);
+    cairo_pattern_set_filter(cairo_get_source(cr), CAIRO_FILTER_NEAREST);
+    cairo_paint(cr);
+    cairo_restore(cr);
+    cairo_surface_destroy(image);
+
+    draw_brackets(cr, start_x, start_y, matrix_w, matrix_h, pad);
+
+    return matrix_w + 2 * pad;
+}
+
+
+/* ------------------ Draw every step (matrices + arrows) ------------------ */
+void draw_steps(cairo_t *cr, StepList *list, gboolean show_text, gboolean show_labels,
+                gboolean cache_text, int wrap_width, int page_height,
+                int *out_width, int *out_height)
+{
+    int start_x = STEPS_MARGIN;
+    int start_y = STEPS_MARGIN;
+    int offset_x = start_x;
+    int offset_y = start_y;
+    int row_spacing = 60;
+    int col_spacing = 40;
+
+    int max_row_height = 0;
+    int total_width = start_x;
+    int total_height = start_y;
+
+    int prev_matrix_h = 0;
+
+    /* Steps not laid out yet that start past the clip are sized from the
+       average laid-out cell and label instead, so a loaded session only lays
+       out what is seen */
+    double clip_x1, clip_y1, clip_x2, clip_y2;
+    cairo_clip_extents(cr, &clip_x1, &clip_y1, &clip_x2, &clip_y2);
+    long seen_width = 0, seen_cols = 0, seen_height = 0, seen_rows = 0;
+    long seen_label_width = 0, seen_labels = 0;
+
+    /* One layout measures and draws every step of this pass */
+    PangoLayout *layout = show_text ? step_layout_create(cr) : NULL;
+    if (cache_text) list->free_text_cache = (GDestroyNotify)cairo_surface_destroy;
+
+    for (int s = 0; s < list->count; s++) {
+        MatrixStep *step = &list->steps[s];
+
+        int matrix_h = 0;
+        int matrix_w = 0;
+        int past_clip = !step->laid_out && (offset_x > clip_x2 || offset_y > clip_y2);
+
+        if (step->matrix && show_text && past_clip) {
+            int cell_w = seen_cols ? seen_width / seen_cols : ESTIMATED_CELL_WIDTH;
+            int cell_h = seen_rows ? seen_height / seen_rows : ESTIMATED_CELL_HEIGHT;
+            matrix_w = step->cols * cell_w + 2 * BRACKET_PAD;
+            matrix_h = step->rows * cell_h + 2 * BRACKET_PAD;
+        } else if (step->matrix) {
+            matrix_w = show_text
+                ? draw_matrix(cr, layout, step, offset_x, offset_y, cache_text, &matrix_h)
+                : draw_matrix_heatmap(cr, step, offset_x, offset_y, &matrix_h);
+            if (show_text) {
+                for (int j = 0; j < step->cols; j++) seen_width += step->col_width[j];
+                for (int i = 0; i < step->rows; i++) seen_height += step->row_height[i];
+                seen_cols += step->cols;
+                seen_rows += step->rows;
+            }
+        }
+
+        if (step->matrix) {
+            prev_matrix_h = matrix_h;
+
+            offset_x += matrix_w + col_spacing;
+            if (matrix_h > max_row_height) max_row_height = matrix_h;
+
+            /* Wrap onto a new line; the next arrow starts it */
+            if (wrap_width > 0 && offset_x > wrap_width && s + 1 < list->count) {
+                if (offset_x > total_width) total_width = offset_x;
+                offset_x = start_x;
+                offset_y += max_row_height + row_spacing;
+
+                /* Lines share a height (every snapshot has the same rows), so a
+                   line that would cross a page break starts the next page */
+                if (page_height > 0) {
+                    int page_end = (offset_y / page_height + 1) * page_height;
+                    if (offset_y + max_row_height + STEPS_MARGIN > page_end)
+                        offset_y = page_end + start_y;
+                }
+                max_row_height = 0;
+            }
+
+        } else {
+            /* ---------------- Measure arrow text ---------------- */
+            int text_w = 0, text_h = 0;
+            gboolean labelled = show_text && show_labels;
+            const char *label = labelled && !past_clip ? step_label(step) : NULL;
+
+            if (label) {
+                layout_step(layout, step);
+                text_w = step->label_w;
+                text_h = step->label_h;
+                seen_label_width += text_w;
+                seen_labels++;
+            } else if (labelled && past_clip && seen_labels) {
+                text_w = seen_label_width / seen_labels;
+            }
+
+            /* ---------------- Compute arrow block width ---------------- */
+            int min_arrow_width = 80;
+            int padding = 40;
+
+            int arrow_block_width =
+                (text_w + padding > min_arrow_width)
+                ? text_w + padding
+                : min_arrow_width;
+
+            double arrow_start_x = offset_x;
+            double arrow_end_x   = offset_x + arrow_block_width;
+            double arrow_mid_y   = offset_y + prev_matrix_h / 2.0;
+
+            double text_x =
+                arrow_start_x +
+                (arrow_block_width / 2.0) -
+                (text_w / 2.0);
+
+            double text_y =
+                arrow_mid_y - text_h - 15;
+
+            if (outside_clip(cr, arrow_start_x, fmin(text_y, arrow_mid_y - 12),
+                             arrow_end_x, arrow_mid_y + 12)) {
+                drop_step_text(step);
+            } else {
+                /* ---------------- Draw Arrow ---------------- */
+                draw_arrow(cr,
+                           arrow_start_x,
+                           arrow_mid_y,
+                           arrow_end_x,
+                           arrow_mid_y,
+                           12);
+
+                /* ---------------- Draw Centered Text ---------------- */
+                if (label) show_step_text(cr, layout, step, text_x, text_y, cache_text);
+                else drop_step_text(step);
+            }
+
+            offset_x += arrow_block_width + col_spacing;
+        }
+
+        if (offset_y + max_row_height > total_height)
+            total_height = offset_y + max_row_height;
+
+        if (offset_x > total_width)
+            total_width = offset_x;
+    }
+
+    if (layout) g_object_unref(layout);
+
+    if (out_width) *out_width = total_width + STEPS_MARGIN;
+    if (out_height) *out_height = total_height + STEPS_MARGIN;
+}
@@ -0,0 +1,92 @@
+#include "matrix_operations.h"
+#include "rref_service.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+
+/*
+ * Local solver client:
+ *   rref_client <socket> [--steps] [--mixed] <rows> <cols> <v11> <v12> ...
+ */
+
+int main(int argc, char *argv[]) {
+    int arg = 1;
+    if (argc < 4) goto usage;
+    const char *path = argv[arg++];
+
+    uint32_t flags = 0;
+    for (; arg < argc && strncmp(argv[arg], "--", 2) == 0; arg++) {
+        if (strcmp(argv[arg], "--steps") == 0) flags |= SERVICE_WANT_STEPS;
+        else if (strcmp(argv[arg], "--mixed") == 0) flags |= SERVICE_MIXED;
+        else goto usage;
+    }
+    if (argc - arg < 2) goto usage;
+
+    int rows = atoi(argv[arg++]);
+    int cols = atoi(argv[arg++]);
+    if (rows <= 0 || cols <= 0 || rows > SERVICE_MAX_DIM || cols > SERVICE_MAX_DIM ||
+        argc - arg != rows * cols)
+        goto usage;
+
+    double *values = malloc((size_t)rows * cols * sizeof(double));
+    for (int k = 0; k < rows * cols; k++) {
+        const char *text = argv[arg + k];
+        char *endptr;
+        errno = 0;
+        values[k] = strtod(text, &endptr);
+        if (endptr == text || *endptr != '\0' || errno == ERANGE) {
+            fprintf(stderr, "invalid value: %s\n", text);
+            free(values);
+            return 2;
+        }
+    }
+
+    int fd = service_connect(path);
+    if (fd < 0) {
+        fprintf(stderr, "%s: %s\n", path, strerror(errno));
+        free(values);
+        return 1;
+    }
+
+    ServiceResult result;
+    if (service_send_request(fd, 1, flags, rows, cols, values) != 0 ||
+        service_read_result(fd, &result) != 0) {
+        fprintf(stderr, "request failed: %s\n", errno ? strerror(errno) : "connection closed");
+        close(fd);
+        free(values);
+        return 1;
+    }
+    close(fd);
+    free(values);
+
+    if (result.header.status != SERVICE_OK) {
+        fprintf(stderr, "server error %d\n", result.header.status);
+        service_free_result(&result);
+        return 1;
+    }
+
+    if (result.steps) printf("%s\n", result.steps);
+
+    char buffer[64];
+    for (uint32_t i = 0; i < result.header.rows; i++) {
+        printf("[");
+        for (uint32_t j = 0; j < result.header.cols; j++) {
+            format_fraction(result.matrix[i * result.header.cols + j], buffer, sizeof(buffer));
+            printf(" %8s", buffer);
+        }
+        printf(" ]\n");
+    }
+
+    printf("rank: %u\npivots:", result.header.rank);
+    for (uint32_t k = 0; k < result.header.rank; k++) printf(" %u", result.pivots[k] + 1);
+    printf("\n");
+
+    service_free_result(&result);
+    return 0;
+
+usage:
+    fprintf(stderr, "usage: %s <socket> [--steps] [--mixed] <rows> <cols> <values...>\n", argv[0]);
+    return 2;
+}
@@ -0,0 +1,390 @@
+#include "matrix_operations.h"
+#include "r-ref.h"
+#include "session.h"
+#include "render.h"
+#include "step_layout.h"
+#include <cairo-pdf.h>
+#include <cairo-svg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+/*
+ * Headless exporter for worked RREF solutions:
+ *   rref_export [--format png|svg|pdf] [--output PATH] [--threads N] [--wrap PX]
+ *               [--labels on|off] <inputs...>
+ *
+ * Inputs ending in ".rref" are saved sessions; any other file holds one
+ * problem per line as "rows cols v11 v12 ..." ('#' starts a comment line).
+ *
+ * Every problem is solved and drawn on a worker thread, one PAGE_HEIGHT page
+ * at a time with lines kept whole. PNG and SVG workers write
+ * problem_NNNNN.<ext>, or problem_NNNNN_pageKKKK.<ext> for a problem that
+ * needs several pages, into the output directory themselves. For PDF each
+ * worker records its pages, and the main thread appends them to one
+ * multi-page file in order, with only a bounded number of pages in flight.
+ */
+
+#define DEFAULT_WRAP       1600
+#define MAX_WRAP           8000   // widest line plus margins stays under the 14400-unit PDF page limit
+#define PAGE_HEIGHT        2048   // holds a line of MAX_PROBLEM_DIM-row matrices with margins
+#define MAX_PROBLEM_DIM    32     // rref() snapshots all rows*cols cells after each of ~rows^2 steps
+#define JOBS_PER_THREAD    2      // PDF problems started ahead of the one being written, per worker
+#define PAGES_IN_FLIGHT    4      // recorded PDF pages a worker may hold before the main thread takes them
+
+typedef enum { EXPORT_PNG, EXPORT_SVG, EXPORT_PDF } ExportFormat;
+
+typedef struct {
+    char *session_path;   // set for .rref inputs
+    int rows;
+    int cols;
+    double *values;       // rows*cols, row-major
+} Problem;
+
+typedef struct {
+    const Problem *problem;
+    int index;
+    int width;
+    int height;             // whole drawing; split into PAGE_HEIGHT pages
+    cairo_surface_t *pages[PAGES_IN_FLIGHT];  // recorded, not yet written (PDF only)
+    int produced;           // pages recorded by the worker
+    int consumed;           // pages written by the main thread
+    int failed;
+    int done;
+} Job;
+
+typedef struct {
+    ExportFormat format;
+    const char *output;
+    int wrap;
+    int labels;
+    GMutex lock;
+    GCond progress;         // a job recorded or finished a page, or the main thread took one
+} ExportContext;
+
+/* ---------------- Input parsing ---------------- */
+static int ends_with(const char *s, const char *suffix) {
+    size_t n = strlen(s), m = strlen(suffix);
+    return n >= m && strcmp(s + n - m, suffix) == 0;
+}
+
+static int parse_problem(char *line, Problem *p) {
+    char *end;
+    long rows = strtol(line, &end, 10);
+    long cols = strtol(end, &end, 10);
+    if (rows <= 0 || cols <= 0 || rows > MAX_PROBLEM_DIM || cols > MAX_PROBLEM_DIM) return 0;
+
+    p->session_path = NULL;
+    p->rows = rows;
+    p->cols = cols;
+    p->values = malloc(rows * cols * sizeof(double));
+    for (long k = 0; k < rows * cols; k++) {
+        char *start = end;
+        p->values[k] = strtod(start, &end);
+        if (end == start) { free(p->values); return 0; }
+    }
+
+    /* Exactly rows*cols values: anything left over means the line is malformed */
+    end += strspn(end, " \t\r\n");
+    if (*end != '\0') { free(p->values); return 0; }
+    return 1;
+}
+
+static int read_inputs(int argc, char *argv[], Problem **out, int *count) {
+    int capacity = 64;
+    Problem *problems = malloc(capacity * sizeof(Problem));
+    *count = 0;
+
+    for (int a = 0; a < argc; a++) {
+        if (*count == capacity) {
+            capacity *= 2;
+            problems = realloc(problems, capacity * sizeof(Problem));
+        }
+        if (ends_with(argv[a], ".rref")) {
+            problems[(*count)++] = (Problem){ strdup(argv[a]), 0, 0, NULL };
+            continue;
+        }
+
+        FILE *f = fopen(argv[a], "r");
+        if (!f) {
+            fprintf(stderr, "%s: %s\n", argv[a], strerror(errno));
+            *out = problems;
+            return 0;
+        }
+        char *line = NULL;
+        size_t len = 0;
+        int lineno = 0;
+        while (getline(&line, &len, f) != -1) {
+            lineno++;
+            char *p = line + strspn(line, " \t");
+            if (*p == '#' || *p == '\n' || *p == '\0') continue;
+            if (*count == capacity) {
+                capacity *= 2;
+                problems = realloc(problems, capacity * sizeof(Problem));
+            }
+            if (!parse_problem(p, &problems[*count])) {
+                fprintf(stderr, "%s:%d: invalid problem (expected rows cols and rows*cols values, "
+                                "at most %d x %d)\n", argv[a], lineno, MAX_PROBLEM_DIM, MAX_PROBLEM_DIM);
+                continue;
+            }
+            (*count)++;
+        }
+        free(line);
+        fclose(f);
+    }
+    *out = problems;
+    return 1;
+}
+
+/* ---------------- Rendering (worker threads) ---------------- */
+static int page_count(const Job *job) {
+    return (job->height + PAGE_HEIGHT - 1) / PAGE_HEIGHT;
+}
+
+// Height of page k; the last page is cut to the drawing
+static int page_height(const Job *job, int k) {
+    int rest = job->height - k * PAGE_HEIGHT;
+    return rest < PAGE_HEIGHT ? rest : PAGE_HEIGHT;
+}
+
+// Draw page k of list at the origin of cr; steps off the page are skipped
+static void draw_page(cairo_t *cr, StepList *list, const ExportContext *ctx, const Job *job, int k) {
+    int top = k * PAGE_HEIGHT;
+    cairo_save(cr);
+    cairo_rectangle(cr, 0, 0, job->width, page_height(job, k));
+    cairo_clip(cr);
+    cairo_set_source_rgb(cr, 1, 1, 1);
+    cairo_paint(cr);
+    cairo_translate(cr, 0, -top);
+    cairo_set_source_rgb(cr, 0, 0, 0);
+    draw_steps(cr, list, TRUE, ctx->labels, FALSE, ctx->wrap, PAGE_HEIGHT, NULL, NULL);
+    cairo_restore(cr);
+}
+
+// Full drawing size; every step is laid out, so with an empty clip this only measures
+static void measure_steps(StepList *list, const ExportContext *ctx, Job *job) {
+    cairo_surface_t *surface = cairo_recording_surface_create(CAIRO_CONTENT_COLOR_ALPHA, NULL);
+    cairo_t *cr = cairo_create(surface);
+    cairo_rectangle(cr, 0, 0, 0, 0);
+    cairo_clip(cr);
+    draw_steps(cr, list, TRUE, ctx->labels, FALSE, ctx->wrap, PAGE_HEIGHT, &job->width, &job->height);
+    cairo_destroy(cr);
+    cairo_surface_destroy(surface);
+}
+
+// problem_NNNNN.<ext> for a single page, problem_NNNNN_pageKKKK.<ext> otherwise
+static void page_path(char *path, size_t size, const ExportContext *ctx, const Job *job,
+                      int k, const char *ext)
+{
+    if (page_count(job) == 1)
+        snprintf(path, size, "%s/problem_%05d.%s", ctx->output, job->index + 1, ext);
+    else
+        snprintf(path, size, "%s/problem_%05d_page%04d.%s", ctx->output, job->index + 1, k + 1, ext);
+}
+
+// Write every page as its own PNG or SVG file; 0 on success
+static int write_pages(StepList *list, const ExportContext *ctx, const Job *job) {
+    int failed = 0;
+    for (int k = 0; k < page_count(job); k++) {
+        char path[4096];
+        cairo_surface_t *surface;
+        if (ctx->format == EXPORT_PNG) {
+            page_path(path, sizeof(path), ctx, job, k, "png");
+            surface = cairo_image_surface_create(CAIRO_FORMAT_RGB24, job->width, page_height(job, k));
+        } else {
+            page_path(path, sizeof(path), ctx, job, k, "svg");
+            surface = cairo_svg_surface_create(path, job->width, page_height(job, k));
+        }
+
+        cairo_t *cr = cairo_create(surface);
+        draw_page(cr, list, ctx, job, k);
+        cairo_destroy(cr);
+
+        cairo_status_t status = CAIRO_STATUS_SUCCESS;
+        if (ctx->format == EXPORT_PNG)
+            status = cairo_surface_write_to_png(surface, path);
+        cairo_surface_finish(surface);
+        if (status != CAIRO_STATUS_SUCCESS || cairo_surface_status(surface) != CAIRO_STATUS_SUCCESS) {
+            fprintf(stderr, "%s: write failed\n", path);
+            failed = 1;
+        }
+        cairo_surface_destroy(surface);
+    }
+    return failed;
+}
+
+// Record each page and hand it to the main thread, at most PAGES_IN_FLIGHT ahead
+static void record_pages(StepList *list, ExportContext *ctx, Job *job) {
+    for (int k = 0; k < page_count(job); k++) {
+        cairo_rectangle_t extents = { 0, 0, job->width, page_height(job, k) };
+        cairo_surface_t *page = cairo_recording_surface_create(CAIRO_CONTENT_COLOR_ALPHA, &extents);
+        cairo_t *cr = cairo_create(page);
+        draw_page(cr, list, ctx, job, k);
+        cairo_destroy(cr);
+
+        g_mutex_lock(&ctx->lock);
+        while (job->produced - job->consumed >= PAGES_IN_FLIGHT)
+            g_cond_wait(&ctx->progress, &ctx->lock);
+        job->pages[job->produced++ % PAGES_IN_FLIGHT] = page;
+        g_cond_broadcast(&ctx->progress);
+        g_mutex_unlock(&ctx->lock);
+    }
+}
+
+static void render_job(gpointer data, gpointer user_data) {
+    Job *job = data;
+    ExportContext *ctx = user_data;
+    const Problem *p = job->problem;
+
+    /* Solve, or map the saved session */
+    AppData app = {0};
+    if (p->session_path) {
+        if (session_load(&app.step_list, p->session_path) != 0) {
+            fprintf(stderr, "%s: %s\n", p->session_path, strerror(errno));
+            job->failed = 1;
+        }
+    } else {
+        double (*M)[p->cols] = malloc(sizeof(double[p->rows][p->cols]));
+        memcpy(M, p->values, sizeof(double[p->rows][p->cols]));
+        rref(&app, p->rows, p->cols, M);
+        free(M);
+    }
+
+    /* Lay out once, then draw page by page so no surface holds the whole problem */
+    if (!job->failed) {
+        precompute_step_layouts(&app.step_list, ctx->labels);
+        measure_steps(&app.step_list, ctx, job);
+        if (ctx->format == EXPORT_PDF)
+            record_pages(&app.step_list, ctx, job);
+        else
+            job->failed = write_pages(&app.step_list, ctx, job);
+        free_step_list(&app.step_list);
+    }
+
+    g_mutex_lock(&ctx->lock);
+    job->done = 1;
+    g_cond_broadcast(&ctx->progress);
+    g_mutex_unlock(&ctx->lock);
+}
+
+/* ---------------- PDF assembly (main thread) ---------------- */
+static int write_pdf(ExportContext *ctx, GThreadPool *pool, Job *jobs, int count, int window) {
+    cairo_surface_t *pdf = cairo_pdf_surface_create(ctx->output, 100, 100);
+    cairo_t *cr = cairo_create(pdf);
+    int pushed = 0, failed = 0;
+
+    for (int i = 0; i < count; i++) {
+        while (pushed < count && pushed < i + window)
+            g_thread_pool_push(pool, &jobs[pushed++], NULL);
+
+        /* Each page is written out and dropped as soon as it is next in line */
+        for (;;) {
+            g_mutex_lock(&ctx->lock);
+            while (jobs[i].consumed == jobs[i].produced && !jobs[i].done)
+                g_cond_wait(&ctx->progress, &ctx->lock);
+            cairo_surface_t *page = NULL;
+            if (jobs[i].consumed < jobs[i].produced)
+                page = jobs[i].pages[jobs[i].consumed % PAGES_IN_FLIGHT];
+            g_mutex_unlock(&ctx->lock);
+            if (!page) break;
+
+            cairo_pdf_surface_set_size(pdf, jobs[i].width, page_height(&jobs[i], jobs[i].consumed));
+            cairo_set_source_surface(cr, page, 0, 0);
+            cairo_paint(cr);
+            cairo_show_page(cr);
+            cairo_set_source_rgb(cr, 1, 1, 1);
+            cairo_surface_destroy(page);
+
+            g_mutex_lock(&ctx->lock);
+            jobs[i].consumed++;
+            g_cond_broadcast(&ctx->progress);
+            g_mutex_unlock(&ctx->lock);
+        }
+        if (jobs[i].failed) failed++;
+    }
+
+    cairo_destroy(cr);
+    cairo_surface_finish(pdf);
+    if (cairo_surface_status(pdf) != CAIRO_STATUS_SUCCESS) {
+        fprintf(stderr, "%s: %s\n", ctx->output,
+                cairo_status_to_string(cairo_surface_status(pdf)));
+        failed = count;
+    }
+    cairo_surface_destroy(pdf);
+    return failed;
+}
+
+/* ---------------- Main ---------------- */
+int main(int argc, char *argv[]) {
+    ExportContext ctx = { EXPORT_PDF, NULL, DEFAULT_WRAP, 1 };
+    int threads = g_get_num_processors();
+
+    int a = 1;
+    for (; a < argc && strncmp(argv[a], "--", 2) == 0; a += 2) {
+        if (a + 1 >= argc) { fprintf(stderr, "missing value for %s\n", argv[a]); return 2; }
+        const char *opt = argv[a], *val = argv[a + 1];
+        if (strcmp(opt, "--format") == 0) {
+            if (strcmp(val, "png") == 0) ctx.format = EXPORT_PNG;
+            else if (strcmp(val, "svg") == 0) ctx.format = EXPORT_SVG;
+            else if (strcmp(val, "pdf") == 0) ctx.format = EXPORT_PDF;
+            else { fprintf(stderr, "unknown format: %s\n", val); return 2; }
+        }
+        else if (strcmp(opt, "--output") == 0) ctx.output = val;
+        else if (strcmp(opt, "--threads") == 0) threads = atoi(val);
+        else if (strcmp(opt, "--wrap") == 0) ctx.wrap = atoi(val);
+        else if (strcmp(opt, "--labels") == 0) ctx.labels = strcmp(val, "off") != 0;
+        else { fprintf(stderr, "unknown option: %s\n", opt); return 2; }
+    }
+    if (a >= argc) {
+        fprintf(stderr, "usage: %s [--format png|svg|pdf] [--output PATH] [--threads N] "
+                        "[--wrap PX] [--labels on|off] <inputs...>\n", argv[0]);
+        return 2;
+    }
+    if (threads < 1) threads = 1;
+    if (ctx.wrap < 1 || ctx.wrap > MAX_WRAP) {
+        fprintf(stderr, "--wrap must be between 1 and %d\n", MAX_WRAP);
+        return 2;
+    }
+    if (!ctx.output) ctx.output = ctx.format == EXPORT_PDF ? "steps.pdf" : ".";
+
+    Problem *problems;
+    int count;
+    if (!read_inputs(argc - a, argv + a, &problems, &count)) return 1;
+
+    Job *jobs = calloc(count ? count : 1, sizeof(Job));
+    for (int i = 0; i < count; i++) {
+        jobs[i].problem = &problems[i];
+        jobs[i].index = i;
+    }
+
+    g_mutex_init(&ctx.lock);
+    g_cond_init(&ctx.progress);
+    GThreadPool *pool = g_thread_pool_new(render_job, &ctx, threads, TRUE, NULL);
+    gint64 start = g_get_monotonic_time();
+
+    int failed = 0;
+    if (ctx.format == EXPORT_PDF) {
+        failed = write_pdf(&ctx, pool, jobs, count, threads * JOBS_PER_THREAD);
+        g_thread_pool_free(pool, FALSE, TRUE);
+    } else {
+        for (int i = 0; i < count; i++) g_thread_pool_push(pool, &jobs[i], NULL);
+        g_thread_pool_free(pool, FALSE, TRUE);
+        for (int i = 0; i < count; i++) failed += jobs[i].failed;
+    }
+
+    double elapsed = (g_get_monotonic_time() - start) / 1e6;
+    fprintf(stderr, "exported %d of %d problems in %.2f s (%.0f per minute, %d threads)\n",
+            count - failed, count, elapsed,
+            elapsed > 0 ? (count - failed) * 60.0 / elapsed : 0.0, threads);
+
+    for (int i = 0; i < count; i++) {
+        free(problems[i].session_path);
+        free(problems[i].values);
+    }
+    free(problems);
+    free(jobs);
+    g_mutex_clear(&ctx.lock);
+    g_cond_clear(&ctx.progress);
+    return failed ? 1 : 0;
+}
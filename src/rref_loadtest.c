@@ -0,0 +1,203 @@
+#include "rref_service.h"
+#include "r-ref.h"
+#include "matrix_operations.h"
+#include <glib.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+
+/*
+ * Load generator for rref_server:
+ *   rref_loadtest <socket> [--clients N] [--requests N] [--size N] [--pipeline K] [--steps] [--mixed] [--check]
+ *
+ * Each client thread keeps up to K requests in flight on its own connection
+ * with random size x (size+1) augmented matrices, then the combined
+ * latencies are reported as throughput, p50, p99 and max.
+ *
+ * --check sends consistent overdetermined (size+2) x (size+1) systems on the
+ * mixed path instead and compares every answer with a local rref().
+ */
+
+#define CHECK_TOL 1e-8   // allowed difference from rref(), relative to the largest entry
+
+typedef struct {
+    const char *path;
+    int requests;
+    int size;
+    int pipeline;
+    uint32_t flags;
+    int check;
+    guint32 seed;
+    gint64 *latency_us;   // one entry per completed request
+    int completed;
+    int failed;
+    int mismatched;       // --check answers that differ from rref()
+} Client;
+
+// Random A with entries in [-0.5, 0.5) and b = A x for an integer x
+static void fill_consistent(GRand *rng, int rows, int cols, double *values) {
+    double x[SERVICE_MAX_DIM];
+    for (int j = 0; j < cols - 1; j++) x[j] = g_rand_int_range(rng, -9, 10);
+    for (int i = 0; i < rows; i++) {
+        double *row = values + (size_t)i * cols, b = 0;
+        for (int j = 0; j < cols - 1; j++) {
+            row[j] = g_rand_double_range(rng, -0.5, 0.5);
+            b += row[j] * x[j];
+        }
+        row[cols - 1] = b;
+    }
+}
+
+// Compare a service answer with rref() of the request it answers
+static int matches_rref(int rows, int cols, const double *values, const ServiceResult *result) {
+    if (result->header.rows != (uint32_t)rows || result->header.cols != (uint32_t)cols) return 0;
+
+    double (*M)[cols] = g_malloc((gsize)rows * cols * sizeof(double));
+    memcpy(M, values, (size_t)rows * cols * sizeof(double));
+    AppData app = {0};
+    app.step_list.recording = RECORD_NONE;
+    rref(&app, rows, cols, M);
+    free_step_list(&app.step_list);
+
+    uint32_t rank = 0;
+    double diff = 0, norm = 1;
+    for (int i = 0; i < rows; i++) {
+        int zero_row = 1;
+        for (int j = 0; j < cols; j++) {
+            double got = result->matrix[(size_t)i * cols + j];
+            if (M[i][j] != 0.0) zero_row = 0;
+            if (fabs(got - M[i][j]) > diff) diff = fabs(got - M[i][j]);
+            if (fabs(M[i][j]) > norm) norm = fabs(M[i][j]);
+        }
+        rank += !zero_row;
+    }
+    g_free(M);
+    return rank == result->header.rank && diff <= CHECK_TOL * norm;
+}
+
+static gpointer client_thread(gpointer data) {
+    Client *c = data;
+    int rows = c->check ? c->size + 2 : c->size, cols = c->size + 1;
+    GRand *rng = g_rand_new_with_seed(c->seed);
+
+    int fd = service_connect(c->path);
+    if (fd < 0) {
+        fprintf(stderr, "%s: %s\n", c->path, strerror(errno));
+        c->failed = c->requests;
+        g_rand_free(rng);
+        return NULL;
+    }
+
+    /* --check keeps every request until its answer arrives */
+    double *values = g_new(double, (gsize)rows * cols * (c->check ? c->requests : 1));
+    gint64 *sent_at = g_new(gint64, c->requests);
+    int sent = 0, received = 0;
+
+    while (received < c->requests) {
+        /* Top the pipeline up, then wait for one answer */
+        while (sent < c->requests && sent - received < c->pipeline) {
+            double *request = c->check ? values + (size_t)sent * rows * cols : values;
+            if (c->check)
+                fill_consistent(rng, rows, cols, request);
+            else
+                for (int k = 0; k < rows * cols; k++)
+                    request[k] = g_rand_int_range(rng, -9, 10);
+            sent_at[sent] = g_get_monotonic_time();
+            if (service_send_request(fd, sent, c->flags, rows, cols, request) != 0) goto fail;
+            sent++;
+        }
+
+        ServiceResult result;
+        if (service_read_result(fd, &result) != 0) goto fail;
+        gint64 now = g_get_monotonic_time();
+        if (result.header.status != SERVICE_OK || result.header.id >= (uint32_t)sent) c->failed++;
+        else {
+            c->latency_us[c->completed++] = now - sent_at[result.header.id];
+            if (c->check && !matches_rref(rows, cols, values + (size_t)result.header.id * rows * cols, &result))
+                c->mismatched++;
+        }
+        service_free_result(&result);
+        received++;
+    }
+    goto done;
+
+fail:
+    c->failed += c->requests - received;
+done:
+    close(fd);
+    g_free(values);
+    g_free(sent_at);
+    g_rand_free(rng);
+    return NULL;
+}
+
+static int compare_gint64(const void *a, const void *b) {
+    gint64 x = *(const gint64 *)a, y = *(const gint64 *)b;
+    return (x > y) - (x < y);
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <socket> [--clients N] [--requests N] [--size N] "
+                        "[--pipeline K] [--steps] [--mixed] [--check]\n", argv[0]);
+        return 2;
+    }
+    const char *path = argv[1];
+    int clients = 8, requests = 1000, size = 8, pipeline = 4;
+    uint32_t flags = 0;
+    int check = 0;
+
+    for (int i = 2; i < argc; i++) {
+        if (strcmp(argv[i], "--steps") == 0) flags |= SERVICE_WANT_STEPS;
+        else if (strcmp(argv[i], "--mixed") == 0) flags |= SERVICE_MIXED;
+        else if (strcmp(argv[i], "--check") == 0) { check = 1; flags |= SERVICE_MIXED; }
+        else if (i + 1 >= argc) { fprintf(stderr, "missing value for %s\n", argv[i]); return 2; }
+        else if (strcmp(argv[i], "--clients") == 0) clients = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--requests") == 0) requests = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--size") == 0) size = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--pipeline") == 0) pipeline = atoi(argv[++i]);
+        else { fprintf(stderr, "unknown option: %s\n", argv[i]); return 2; }
+    }
+    if (clients < 1 || requests < 1 || pipeline < 1 || size < 1 || size + 2 > SERVICE_MAX_DIM) {
+        fprintf(stderr, "invalid options\n");
+        return 2;
+    }
+
+    Client *c = g_new0(Client, clients);
+    GThread **threads = g_new(GThread *, clients);
+    gint64 start = g_get_monotonic_time();
+    for (int t = 0; t < clients; t++) {
+        c[t] = (Client){ path, requests, size, pipeline, flags, check, 12345u + t,
+                         g_new0(gint64, requests), 0, 0, 0 };
+        threads[t] = g_thread_new("client", client_thread, &c[t]);
+    }
+    for (int t = 0; t < clients; t++) g_thread_join(threads[t]);
+    double elapsed = (g_get_monotonic_time() - start) / 1e6;
+
+    /* Merge successful latencies */
+    gint64 *all = g_new(gint64, (gsize)clients * requests);
+    long ok = 0, failed = 0, mismatched = 0;
+    for (int t = 0; t < clients; t++) {
+        failed += c[t].failed;
+        mismatched += c[t].mismatched;
+        for (int k = 0; k < c[t].completed; k++)
+            all[ok++] = c[t].latency_us[k];
+        g_free(c[t].latency_us);
+    }
+    qsort(all, ok, sizeof(gint64), compare_gint64);
+
+    printf("requests: %ld ok, %ld failed in %.3f s\n", ok, failed, elapsed);
+    printf("throughput: %.0f req/s\n", ok / elapsed);
+    if (ok > 0) {
+        printf("latency: p50 %.1f us, p99 %.1f us, max %.1f us\n",
+               (double)all[(ok - 1) / 2], (double)all[(ok - 1) * 99 / 100], (double)all[ok - 1]);
+    }
+    if (check) printf("check: %ld of %ld answers differ from rref()\n", mismatched, ok);
+
+    g_free(all);
+    g_free(threads);
+    g_free(c);
+    return failed || mismatched ? 1 : 0;
+}
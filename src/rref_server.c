@@ -0,0 +1,381 @@
+#include "matrix_operations.h"
+#include "r-ref.h"
+#include "rref_service.h"
+#include "mixed_precision.h"
+#include <glib.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+/*
+ * Local solver daemon:
+ *   rref_server <socket> [--threads N] [--batch N] [--window-us U] [--queue-mb M]
+ *
+ * One reader thread per connection parses requests onto a shared queue,
+ * blocking once --queue-mb of matrix data is waiting or being solved, or
+ * once that much of its own responses is still unsent.
+ * A batcher thread drains the queue into batches (up to --batch requests,
+ * waiting at most --window-us for more), groups each batch by connection
+ * and splits it into one slice per worker. A worker hands all responses
+ * of one connection in its slice to that connection's writer thread as a
+ * single buffer, so workers never block on a slow client.
+ */
+
+#define DEFAULT_BATCH     32
+#define DEFAULT_WINDOW_US 200
+#define DEFAULT_QUEUE_MB  64
+
+typedef struct {
+    int fd;
+    GAsyncQueue *responses;  // GString buffers for the writer; the connection itself ends it
+    GMutex lock;
+    GCond drained;
+    gint64 unsent;           // bytes handed to the writer and not yet written
+    gint producers;          // reader thread + one per queued request
+} Connection;
+
+typedef struct {
+    Connection *conn;
+    ServiceRequest req;
+    double *values;
+} Job;
+
+typedef struct {
+    Job **jobs;
+    int count;
+} Batch;
+
+static GAsyncQueue *job_queue;
+static GThreadPool *workers;
+static int worker_count;
+static int batch_max = DEFAULT_BATCH;
+static gint64 batch_window_us = DEFAULT_WINDOW_US;
+
+/* Backpressure: readers stop reading their socket while the queue is full.
+   Only unsolved requests count, and solving never waits on I/O, so it always drains. */
+static GMutex queue_lock;
+static GCond queue_space;
+static gint64 queue_limit = (gint64)DEFAULT_QUEUE_MB << 20;
+static gint64 queue_bytes;   // matrix data of accepted, unanswered requests
+
+// Wait until bytes more fit; an empty queue always admits one request
+static void queue_reserve(gint64 bytes) {
+    g_mutex_lock(&queue_lock);
+    while (queue_bytes > 0 && queue_bytes + bytes > queue_limit)
+        g_cond_wait(&queue_space, &queue_lock);
+    queue_bytes += bytes;
+    g_mutex_unlock(&queue_lock);
+}
+
+static void queue_release(gint64 bytes) {
+    g_mutex_lock(&queue_lock);
+    queue_bytes -= bytes;
+    g_cond_broadcast(&queue_space);
+    g_mutex_unlock(&queue_lock);
+}
+
+static gint64 job_bytes(const ServiceRequest *req) {
+    return (gint64)req->rows * req->cols * sizeof(double);
+}
+
+/* ---------------- Per-connection writer ---------------- */
+// Queue a buffer of whole responses for the writer, which frees it
+static void send_responses(Connection *conn, GString *out) {
+    g_mutex_lock(&conn->lock);
+    conn->unsent += out->len;
+    g_mutex_unlock(&conn->lock);
+    g_async_queue_push(conn->responses, out);
+}
+
+// Once neither the reader nor any request can send more, tell the writer to finish
+static void connection_done(Connection *conn) {
+    if (g_atomic_int_dec_and_test(&conn->producers))
+        g_async_queue_push(conn->responses, conn);
+}
+
+static gpointer writer_thread(gpointer data) {
+    Connection *conn = data;
+    int failed = 0;
+
+    for (;;) {
+        gpointer item = g_async_queue_pop(conn->responses);
+        if (item == conn) break;
+
+        GString *out = item;
+        if (!failed && service_write_full(conn->fd, out->str, out->len) != 0)
+            failed = 1;  // client went away; keep draining so producers are not stuck
+
+        g_mutex_lock(&conn->lock);
+        conn->unsent -= out->len;
+        g_cond_broadcast(&conn->drained);
+        g_mutex_unlock(&conn->lock);
+        g_string_free(out, TRUE);
+    }
+
+    close(conn->fd);
+    g_async_queue_unref(conn->responses);
+    g_cond_clear(&conn->drained);
+    g_mutex_clear(&conn->lock);
+    g_free(conn);
+    return NULL;
+}
+
+/* ---------------- Solve one request ---------------- */
+static void append_steps(GString *log, StepList *list) {
+    for (int s = 0; s < list->count; s++) {
+        const char *label = step_label(&list->steps[s]);
+        if (!label) continue;
+        g_string_append(log, label);
+        g_string_append_c(log, '\n');
+    }
+}
+
+// Solve one request and append its response to out
+static void solve_job(Job *job, GString *out) {
+    int rows = job->req.rows;
+    int cols = job->req.cols;
+    double (*M)[cols] = (double (*)[cols])job->values;
+
+    /* Mixed precision needs no step log; rank-deficient systems fall back to rref().
+       Only the operations are recorded, never per-step matrix snapshots. */
+    GString *log = NULL;
+    int want_steps = job->req.flags & SERVICE_WANT_STEPS;
+    if (want_steps || !(job->req.flags & SERVICE_MIXED) || !rref_mixed(rows, cols, M)) {
+        AppData app = {0};
+        app.step_list.recording = want_steps ? RECORD_OPS : RECORD_NONE;
+        rref(&app, rows, cols, M);
+        if (want_steps) {
+            log = g_string_new(NULL);
+            append_steps(log, &app.step_list);
+        }
+        free_step_list(&app.step_list);
+    }
+
+    /* Pivots were chosen against the input's rank_tolerance(); both solvers leave
+       rows past the rank exactly zero and pivots exactly 1, so read them off */
+    uint32_t pivots[SERVICE_MAX_DIM];
+    uint32_t rank = 0;
+    for (int i = 0; i < rows; i++)
+        for (int j = 0; j < cols; j++)
+            if (M[i][j] != 0.0) { pivots[rank++] = j; break; }
+
+    ServiceResponse hdr = {
+        SERVICE_MAGIC, job->req.id, SERVICE_OK,
+        rows, cols, rank, log ? (uint32_t)log->len : 0
+    };
+
+    g_string_append_len(out, (const char *)&hdr, sizeof(hdr));
+    g_string_append_len(out, (const char *)job->values, (gssize)rows * cols * sizeof(double));
+    g_string_append_len(out, (const char *)pivots, rank * sizeof(uint32_t));
+    if (log) {
+        g_string_append_len(out, log->str, log->len);
+        g_string_free(log, TRUE);
+    }
+}
+
+static void job_free(Job *job) {
+    connection_done(job->conn);
+    g_free(job->values);
+    g_free(job);
+}
+
+// Jobs of a slice arrive grouped by connection
+static void solve_batch(gpointer data, gpointer user_data) {
+    Batch *batch = data;
+    GString *out = g_string_new(NULL);
+
+    int first = 0;
+    for (int i = 0; i < batch->count; i++) {
+        Job *job = batch->jobs[i];
+        solve_job(job, out);
+        queue_release(job_bytes(&job->req));
+        if (i + 1 < batch->count && batch->jobs[i + 1]->conn == job->conn) continue;
+
+        /* One buffer, so one write, per connection in this slice */
+        send_responses(job->conn, out);
+        out = g_string_new(NULL);
+        for (; first <= i; first++) job_free(batch->jobs[first]);
+    }
+
+    g_string_free(out, TRUE);
+    g_free(batch->jobs);
+    g_free(batch);
+}
+
+/* ---------------- Batching ---------------- */
+static int compare_job_conn(const void *a, const void *b) {
+    uintptr_t x = (uintptr_t)(*(Job *const *)a)->conn;
+    uintptr_t y = (uintptr_t)(*(Job *const *)b)->conn;
+    return (x > y) - (x < y);
+}
+
+static gpointer batcher_thread(gpointer data) {
+    Job **jobs = g_new(Job *, batch_max);
+    for (;;) {
+        jobs[0] = g_async_queue_pop(job_queue);
+        int count = 1;
+
+        /* Coalesce whatever else arrives within the window */
+        gint64 deadline = g_get_monotonic_time() + batch_window_us;
+        while (count < batch_max) {
+            Job *job = g_async_queue_try_pop(job_queue);
+            if (!job) {
+                gint64 remaining = deadline - g_get_monotonic_time();
+                if (remaining <= 0) break;
+                job = g_async_queue_timeout_pop(job_queue, remaining);
+                if (!job) break;
+            }
+            jobs[count++] = job;
+        }
+
+        /* Group by connection, then hand every worker an even contiguous slice */
+        qsort(jobs, count, sizeof(Job *), compare_job_conn);
+        int slices = count < worker_count ? count : worker_count;
+        for (int k = 0; k < slices; k++) {
+            int first = count * k / slices;
+            int last = count * (k + 1) / slices;
+            Batch *batch = g_new(Batch, 1);
+            batch->count = last - first;
+            batch->jobs = g_new(Job *, batch->count);
+            memcpy(batch->jobs, jobs + first, batch->count * sizeof(Job *));
+            g_thread_pool_push(workers, batch, NULL);
+        }
+    }
+    return NULL;
+}
+
+/* ---------------- Per-connection reader ---------------- */
+static void send_error(Connection *conn, const ServiceRequest *req, int32_t status) {
+    ServiceResponse hdr = { SERVICE_MAGIC, req->id, status, 0, 0, 0, 0 };
+    GString *out = g_string_new(NULL);
+    g_string_append_len(out, (const char *)&hdr, sizeof(hdr));
+    send_responses(conn, out);
+}
+
+// A client that does not read its answers only stalls its own connection
+static void wait_for_drain(Connection *conn) {
+    g_mutex_lock(&conn->lock);
+    while (conn->unsent > queue_limit)
+        g_cond_wait(&conn->drained, &conn->lock);
+    g_mutex_unlock(&conn->lock);
+}
+
+static gpointer reader_thread(gpointer data) {
+    Connection *conn = data;
+    ServiceRequest req;
+
+    while (service_read_full(conn->fd, &req, sizeof(req)) == 0) {
+        if (req.magic != SERVICE_MAGIC) break;
+        if (req.rows == 0 || req.cols == 0 ||
+            req.rows > SERVICE_MAX_DIM || req.cols > SERVICE_MAX_DIM) {
+            send_error(conn, &req, SERVICE_ERR_SIZE);
+            break;  // cannot resynchronise without trusting the size
+        }
+
+        wait_for_drain(conn);
+        queue_reserve(job_bytes(&req));
+        Job *job = g_new(Job, 1);
+        job->req = req;
+        job->values = g_new(double, (size_t)req.rows * req.cols);
+        if (service_read_full(conn->fd, job->values,
+                              (size_t)req.rows * req.cols * sizeof(double)) != 0) {
+            queue_release(job_bytes(&req));
+            g_free(job->values);
+            g_free(job);
+            break;
+        }
+        g_atomic_int_inc(&conn->producers);
+        job->conn = conn;
+        g_async_queue_push(job_queue, job);
+    }
+
+    /* Stop reading; the writer keeps the socket open until queued jobs are answered */
+    shutdown(conn->fd, SHUT_RD);
+    connection_done(conn);
+    return NULL;
+}
+
+/* ---------------- Main ---------------- */
+static int listen_on(const char *path) {
+    struct sockaddr_un addr;
+    if (strlen(path) >= sizeof(addr.sun_path)) { errno = ENAMETOOLONG; return -1; }
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path);
+    unlink(path);
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(fd, 128) != 0) {
+        int saved = errno;
+        close(fd);
+        errno = saved;
+        return -1;
+    }
+    return fd;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <socket> [--threads N] [--batch N] [--window-us U] [--queue-mb M]\n",
+                argv[0]);
+        return 2;
+    }
+    const char *path = argv[1];
+    int threads = g_get_num_processors();
+
+    for (int i = 2; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "--threads") == 0) threads = atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "--batch") == 0) batch_max = atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "--window-us") == 0) batch_window_us = atol(argv[i + 1]);
+        else if (strcmp(argv[i], "--queue-mb") == 0) queue_limit = (gint64)atol(argv[i + 1]) << 20;
+        else { fprintf(stderr, "unknown option: %s\n", argv[i]); return 2; }
+    }
+    if (threads < 1) threads = 1;
+    if (batch_max < 1) batch_max = 1;
+    if (batch_window_us < 0) batch_window_us = 0;
+    if (queue_limit < 1) queue_limit = 1;
+    worker_count = threads;
+
+    signal(SIGPIPE, SIG_IGN);
+
+    int listen_fd = listen_on(path);
+    if (listen_fd < 0) {
+        fprintf(stderr, "%s: %s\n", path, strerror(errno));
+        return 1;
+    }
+
+    job_queue = g_async_queue_new();
+    workers = g_thread_pool_new(solve_batch, NULL, threads, TRUE, NULL);
+    g_thread_unref(g_thread_new("batcher", batcher_thread, NULL));
+
+    fprintf(stderr, "rref_server: listening on %s (%d workers, batch %d, window %ld us, queue %ld MB)\n",
+            path, threads, batch_max, (long)batch_window_us, (long)(queue_limit >> 20));
+
+    for (;;) {
+        int fd = accept(listen_fd, NULL, NULL);
+        if (fd < 0) {
+            if (errno == EINTR) continue;
+            perror("accept");
+            break;
+        }
+        Connection *conn = g_new0(Connection, 1);
+        conn->fd = fd;
+        conn->producers = 1;
+        conn->responses = g_async_queue_new();
+        g_mutex_init(&conn->lock);
+        g_cond_init(&conn->drained);
+        g_thread_unref(g_thread_new("writer", writer_thread, conn));
+        g_thread_unref(g_thread_new("reader", reader_thread, conn));
+    }
+
+    close(listen_fd);
+    unlink(path);
+    return 1;
+}
@@ -0,0 +1,91 @@
+#include "rref_service.h"
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+/* ---------------- Socket I/O ---------------- */
+int service_read_full(int fd, void *buf, size_t len) {
+    char *p = buf;
+    while (len > 0) {
+        ssize_t n = read(fd, p, len);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return -1;
+        p += n; len -= n;
+    }
+    return 0;
+}
+
+int service_write_full(int fd, const void *buf, size_t len) {
+    const char *p = buf;
+    while (len > 0) {
+        ssize_t n = send(fd, p, len, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return -1;
+        p += n; len -= n;
+    }
+    return 0;
+}
+
+int service_connect(const char *path) {
+    struct sockaddr_un addr;
+    if (strlen(path) >= sizeof(addr.sun_path)) { errno = ENAMETOOLONG; return -1; }
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path);
+    if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+        int saved = errno;
+        close(fd);
+        errno = saved;
+        return -1;
+    }
+    return fd;
+}
+
+/* ---------------- Client side ---------------- */
+int service_send_request(int fd, uint32_t id, uint32_t flags,
+                         int rows, int cols, const double *values) {
+    ServiceRequest req = { SERVICE_MAGIC, id, flags, rows, cols };
+    if (service_write_full(fd, &req, sizeof(req)) != 0) return -1;
+    return service_write_full(fd, values, (size_t)rows * cols * sizeof(double));
+}
+
+int service_read_result(int fd, ServiceResult *result) {
+    memset(result, 0, sizeof(*result));
+    ServiceResponse *hdr = &result->header;
+    if (service_read_full(fd, hdr, sizeof(*hdr)) != 0) return -1;
+    if (hdr->magic != SERVICE_MAGIC || hdr->rows > SERVICE_MAX_DIM ||
+        hdr->cols > SERVICE_MAX_DIM || hdr->rank > hdr->rows) {
+        errno = EPROTO;
+        return -1;
+    }
+
+    size_t cells = (size_t)hdr->rows * hdr->cols;
+    result->matrix = malloc((cells ? cells : 1) * sizeof(double));
+    result->pivots = malloc((hdr->rank ? hdr->rank : 1) * sizeof(uint32_t));
+    if (hdr->steps_size) result->steps = malloc(hdr->steps_size + 1);
+
+    if (service_read_full(fd, result->matrix, cells * sizeof(double)) != 0 ||
+        service_read_full(fd, result->pivots, hdr->rank * sizeof(uint32_t)) != 0 ||
+        (hdr->steps_size && service_read_full(fd, result->steps, hdr->steps_size) != 0)) {
+        service_free_result(result);
+        return -1;
+    }
+    if (result->steps) result->steps[hdr->steps_size] = '\0';
+    return 0;
+}
+
+void service_free_result(ServiceResult *result) {
+    free(result->matrix);
+    free(result->pivots);
+    free(result->steps);
+    result->matrix = NULL;
+    result->pivots = NULL;
+    result->steps = NULL;
+}
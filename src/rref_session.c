@@ -0,0 +1,123 @@
+#include "matrix_operations.h"
+#include "r-ref.h"
+#include "session.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+
+/*
+ * Headless session tool:
+ *   rref_session solve <out.rref> <rows> <cols> <v11> <v12> ...
+ *   rref_session show  <in.rref>
+ *   rref_session info  <in.rref>
+ */
+
+static double elapsed_ms(struct timespec a, struct timespec b) {
+    return (b.tv_sec - a.tv_sec) * 1e3 + (b.tv_nsec - a.tv_nsec) / 1e6;
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr,
+            "usage: %s solve <out.rref> <rows> <cols> <values...>\n"
+            "       %s show <in.rref>\n"
+            "       %s info <in.rref>\n", prog, prog, prog);
+}
+
+static int cmd_solve(int argc, char *argv[]) {
+    if (argc < 5) return 2;
+    const char *path = argv[2];
+    int rows = atoi(argv[3]);
+    int cols = atoi(argv[4]);
+    if (rows <= 0 || cols <= 0 || argc != 5 + rows * cols) {
+        fprintf(stderr, "expected %d x %d values\n", rows, cols);
+        return 2;
+    }
+
+    double (*M)[cols] = malloc(sizeof(double[rows][cols]));
+    for (int i = 0; i < rows; i++)
+        for (int j = 0; j < cols; j++) {
+            const char *text = argv[5 + i * cols + j];
+            char *endptr;
+            errno = 0;
+            M[i][j] = strtod(text, &endptr);
+            if (endptr == text || *endptr != '\0' || errno == ERANGE) {
+                fprintf(stderr, "invalid value: %s\n", text);
+                free(M);
+                return 2;
+            }
+        }
+
+    AppData app = {0};
+    rref(&app, rows, cols, M);
+    free(M);
+
+    int status = 0;
+    if (session_save(&app.step_list, path, 1) != 0) {
+        fprintf(stderr, "%s: %s\n", path, strerror(errno));
+        status = 1;
+    }
+    free_step_list(&app.step_list);
+    return status;
+}
+
+static int cmd_show(const char *path) {
+    StepList list = {0};
+    if (session_load(&list, path) != 0) {
+        fprintf(stderr, "%s: %s\n", path, strerror(errno));
+        return 1;
+    }
+
+    char buffer[64];
+    for (int s = 0; s < list.count; s++) {
+        MatrixStep *step = &list.steps[s];
+        if (!step->matrix) {
+            const char *label = step_label(step);
+            printf("  --[ %s ]-->\n", label ? label : "");
+            continue;
+        }
+        for (int i = 0; i < step->rows; i++) {
+            printf("[");
+            for (int j = 0; j < step->cols; j++) {
+                format_fraction(step->matrix[i][j], buffer, sizeof(buffer));
+                printf(" %8s", buffer);
+            }
+            printf(" ]\n");
+        }
+    }
+    free_step_list(&list);
+    return 0;
+}
+
+static int cmd_info(const char *path) {
+    struct timespec t0, t1;
+    StepList list = {0};
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    int rc = session_load(&list, path);
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    if (rc != 0) {
+        fprintf(stderr, "%s: %s\n", path, strerror(errno));
+        return 1;
+    }
+
+    int matrices = 0;
+    for (int s = 0; s < list.count; s++)
+        if (list.steps[s].matrix) matrices++;
+
+    printf("%s: %d steps (%d matrices, %d operations), %zu bytes, loaded in %.3f ms\n",
+           path, list.count, matrices, list.count - matrices,
+           list.mapping_size, elapsed_ms(t0, t1));
+    free_step_list(&list);
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    int status = 2;
+    if (argc >= 2 && strcmp(argv[1], "solve") == 0) status = cmd_solve(argc, argv);
+    else if (argc == 3 && strcmp(argv[1], "show") == 0) status = cmd_show(argv[2]);
+    else if (argc == 3 && strcmp(argv[1], "info") == 0) status = cmd_info(argv[2]);
+
+    if (status == 2) usage(argv[0]);
+    return status;
+}
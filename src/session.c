@@ -0,0 +1,231 @@
+#include "session.h"
+#include "matrix_operations.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define ALIGN8(x) (((x) + 7u) & ~(uint64_t)7u)
+
+/* ---------------- Save ---------------- */
+int session_save(StepList *list, const char *path, int with_labels) {
+    SessionHeader hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, SESSION_MAGIC, sizeof(hdr.magic));
+    hdr.version = SESSION_VERSION;
+    hdr.byte_order = SESSION_BYTE_ORDER;
+    hdr.step_count = list->count;
+
+    SessionStep *index = calloc(list->count ? list->count : 1, sizeof(SessionStep));
+    if (!index) return -1;
+
+    /* Build the step index and size the cell and string sections */
+    uint64_t cells = 0, strings = 0;
+    for (int s = 0; s < list->count; s++) {
+        MatrixStep *step = &list->steps[s];
+        if (step->matrix) {
+            index[s].rows = step->rows;
+            index[s].cols = step->cols;
+            index[s].offset = cells;
+            cells += (uint64_t)step->rows * step->cols;
+            continue;
+        }
+        index[s].op_type = step->op.type;
+        index[s].op_dest = step->op.dest;
+        index[s].op_src = step->op.src;
+        index[s].op_coeff = step->op.coeff;
+        const char *label = with_labels ? step_label(step) : NULL;
+        if (label) {
+            index[s].offset = strings;
+            strings += strlen(label) + 1;
+        } else {
+            index[s].offset = SESSION_NO_LABEL;
+        }
+    }
+
+    hdr.steps_offset = ALIGN8(sizeof(SessionHeader));
+    hdr.cells_offset = ALIGN8(hdr.steps_offset + (uint64_t)list->count * sizeof(SessionStep));
+    hdr.cells_count = cells;
+    hdr.strings_offset = hdr.cells_offset + cells * sizeof(double);
+    hdr.strings_size = strings;
+    hdr.file_size = hdr.strings_offset + strings;
+
+    /* Write beside path and rename over it: path may be the file mapped by list */
+    size_t path_len = strlen(path);
+    char *tmp_path = malloc(path_len + sizeof(".tmp"));
+    if (!tmp_path) { free(index); return -1; }
+    memcpy(tmp_path, path, path_len);
+    memcpy(tmp_path + path_len, ".tmp", sizeof(".tmp"));
+
+    FILE *f = fopen(tmp_path, "wb");
+    if (!f) { free(index); free(tmp_path); return -1; }
+
+    static const char zeros[8];
+    int ok = fwrite(&hdr, sizeof(hdr), 1, f) == 1;
+    ok = ok && fwrite(zeros, 1, hdr.steps_offset - sizeof(hdr), f) == hdr.steps_offset - sizeof(hdr);
+    if (list->count)
+        ok = ok && fwrite(index, sizeof(SessionStep), list->count, f) == (size_t)list->count;
+    uint64_t pos = hdr.steps_offset + (uint64_t)list->count * sizeof(SessionStep);
+    ok = ok && fwrite(zeros, 1, hdr.cells_offset - pos, f) == hdr.cells_offset - pos;
+
+    for (int s = 0; ok && s < list->count; s++) {
+        const MatrixStep *step = &list->steps[s];
+        if (!step->matrix) continue;
+        for (int i = 0; ok && i < step->rows; i++)
+            ok = fwrite(step->matrix[i], sizeof(double), step->cols, f) == (size_t)step->cols;
+    }
+    for (int s = 0; ok && s < list->count; s++) {
+        const MatrixStep *step = &list->steps[s];
+        if (step->matrix || index[s].offset == SESSION_NO_LABEL) continue;
+        size_t len = strlen(step->above_arrow) + 1;
+        ok = fwrite(step->above_arrow, 1, len, f) == len;
+    }
+
+    free(index);
+    if (fclose(f) != 0) ok = 0;
+    if (ok && rename(tmp_path, path) != 0) ok = 0;
+    if (!ok) {
+        int saved = errno ? errno : EIO;
+        remove(tmp_path);
+        free(tmp_path);
+        errno = saved;
+        return -1;
+    }
+    free(tmp_path);
+    return 0;
+}
+
+/* ---------------- Load ---------------- */
+// Read step s of either index layout as a version 2 record
+static SessionStep session_step(const SessionHeader *hdr, const unsigned char *base, uint32_t s) {
+    if (hdr->version >= 2)
+        return ((const SessionStep *)(base + hdr->steps_offset))[s];
+
+    const SessionStepV1 *v1 = (const SessionStepV1 *)(base + hdr->steps_offset) + s;
+    SessionStep step = { v1->rows, v1->cols, v1->offset, OP_NONE, 0, 0, 0, 0.0 };
+    return step;
+}
+
+static size_t session_step_size(const SessionHeader *hdr) {
+    return hdr->version >= 2 ? sizeof(SessionStep) : sizeof(SessionStepV1);
+}
+
+static int session_validate(const unsigned char *base, size_t size) {
+    if (size < sizeof(SessionHeader)) return 0;
+    const SessionHeader *hdr = (const SessionHeader *)base;
+    if (memcmp(hdr->magic, SESSION_MAGIC, sizeof(hdr->magic)) != 0) return 0;
+    if (hdr->version < 1 || hdr->version > SESSION_VERSION) return 0;
+    if (hdr->byte_order != SESSION_BYTE_ORDER) return 0;
+    if (hdr->file_size != size) return 0;
+    if (hdr->steps_offset % 8 || hdr->cells_offset % 8) return 0;
+
+    /* Sections must be ordered inside the file; every check below is a subtraction that cannot wrap */
+    if (hdr->steps_offset < sizeof(SessionHeader) || hdr->steps_offset > hdr->cells_offset ||
+        hdr->cells_offset > hdr->strings_offset || hdr->strings_offset > size)
+        return 0;
+    if (hdr->step_count > (hdr->cells_offset - hdr->steps_offset) / session_step_size(hdr)) return 0;
+    if (hdr->cells_count != (hdr->strings_offset - hdr->cells_offset) / sizeof(double) ||
+        (hdr->strings_offset - hdr->cells_offset) % sizeof(double))
+        return 0;
+    if (hdr->strings_size != size - hdr->strings_offset) return 0;
+    if (hdr->strings_size && base[size - 1] != '\0') return 0;
+
+    for (uint32_t s = 0; s < hdr->step_count; s++) {
+        SessionStep step = session_step(hdr, base, s);
+        if (step.rows) {
+            if (!step.cols || step.rows > INT_MAX || step.cols > INT_MAX || step.offset > hdr->cells_count ||
+                (uint64_t)step.rows * step.cols > hdr->cells_count - step.offset)
+                return 0;
+        } else {
+            // Every arrow step carries an op, labelled or not
+            if (step.op_type > OP_ADD) return 0;
+            if (step.offset != SESSION_NO_LABEL && step.offset >= hdr->strings_size) return 0;
+        }
+    }
+    return 1;
+}
+
+int session_load(StepList *list, const char *path) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return -1;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) { close(fd); return -1; }
+    size_t size = (size_t)st.st_size;
+    if (size < sizeof(SessionHeader)) { close(fd); errno = EINVAL; return -1; }
+
+    void *base = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) return -1;
+
+    if (!session_validate(base, size)) {
+        munmap(base, size);
+        errno = EINVAL;
+        return -1;
+    }
+
+    const SessionHeader *hdr = base;
+    double *cells = (double *)((char *)base + hdr->cells_offset);
+    char *strings = (char *)base + hdr->strings_offset;
+
+    /* One allocation for all row pointers keeps a 10k-step load to two mallocs */
+    uint64_t total_rows = 0;
+    for (uint32_t s = 0; s < hdr->step_count; s++) total_rows += session_step(hdr, base, s).rows;
+
+    MatrixStep *steps = calloc(hdr->step_count ? hdr->step_count : 1, sizeof(MatrixStep));
+    double **row_ptrs = malloc((total_rows ? total_rows : 1) * sizeof(double *));
+    if (!steps || !row_ptrs) {
+        free(steps); free(row_ptrs);
+        munmap(base, size);
+        errno = ENOMEM;
+        return -1;
+    }
+
+    double **next_row = row_ptrs;
+    for (uint32_t s = 0; s < hdr->step_count; s++) {
+        MatrixStep *step = &steps[s];
+        SessionStep entry = session_step(hdr, base, s);
+        if (entry.rows) {
+            step->rows = entry.rows;
+            step->cols = entry.cols;
+            step->matrix = next_row;
+            for (uint32_t i = 0; i < entry.rows; i++)
+                *next_row++ = cells + entry.offset + (uint64_t)i * entry.cols;
+            step->above_arrow = NULL;
+        } else {
+            step->rows = 0;
+            step->cols = 0;
+            step->matrix = NULL;
+            step->above_arrow = entry.offset == SESSION_NO_LABEL ? NULL : strings + entry.offset;
+            step->op = (RowOp){ entry.op_type, entry.op_dest, entry.op_src, entry.op_coeff };
+        }
+    }
+
+    list->steps = steps;
+    list->count = hdr->step_count;
+    list->mapping = base;
+    list->mapping_size = size;
+    list->row_ptrs = row_ptrs;
+    return 0;
+}
+
+int session_owns(const StepList *list, const void *ptr) {
+    const char *base = list->mapping;
+    return ptr && base && (const char *)ptr >= base && (const char *)ptr < base + list->mapping_size;
+}
+
+void session_release(StepList *list) {
+    free(list->steps);
+    free(list->row_ptrs);
+    munmap(list->mapping, list->mapping_size);
+    list->steps = NULL;
+    list->count = 0;
+    list->mapping = NULL;
+    list->mapping_size = 0;
+    list->row_ptrs = NULL;
+}
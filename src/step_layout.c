@@ -0,0 +1,193 @@
+#include "step_layout.h"
+#include "matrix_operations.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* ---------------- Single step ---------------- */
+static void layout_matrix(PangoLayout *layout, MatrixStep *step) {
+    int rows = step->rows;
+    int cols = step->cols;
+    int cells = rows * cols;
+
+    /* Format every cell once into a packed, NUL-separated buffer */
+    size_t capacity = (size_t)cells * 8 + 64, used = 0;
+    char *text = malloc(capacity);
+    int *offset = malloc(cells * sizeof(int));
+    for (int i = 0; i < rows; i++)
+        for (int j = 0; j < cols; j++) {
+            char buffer[64];
+            format_for_step(step->matrix[i][j], buffer, sizeof(buffer));
+            size_t len = strlen(buffer) + 1;
+            if (used + len > capacity) {
+                capacity *= 2;
+                text = realloc(text, capacity);
+            }
+            memcpy(text + used, buffer, len);
+            offset[i * cols + j] = used;
+            used += len;
+        }
+
+    /* Measure cell extents into padded column widths / row heights */
+    int *cell_width = malloc(cells * sizeof(int));
+    int *col_width = calloc(cols, sizeof(int));
+    int *row_height = calloc(rows, sizeof(int));
+    for (int i = 0; i < rows; i++)
+        for (int j = 0; j < cols; j++) {
+            int tw, th;
+            pango_layout_set_text(layout, text + offset[i * cols + j], -1);
+            pango_layout_get_pixel_size(layout, &tw, &th);
+            cell_width[i * cols + j] = tw;
+            if (tw > col_width[j]) col_width[j] = tw;
+            if (th > row_height[i]) row_height[i] = th;
+        }
+    for (int j = 0; j < cols; j++) col_width[j] += CELL_PADDING;
+    for (int i = 0; i < rows; i++) row_height[i] += CELL_PADDING;
+
+    step->cell_text = text;
+    step->cell_offset = offset;
+    step->cell_width = cell_width;
+    step->col_width = col_width;
+    step->row_height = row_height;
+}
+
+void layout_step(PangoLayout *layout, MatrixStep *step) {
+    if (step->laid_out) return;
+
+    PangoFontDescription *desc =
+        pango_font_description_from_string(step->matrix ? CELL_FONT : ARROW_FONT);
+    pango_layout_set_font_description(layout, desc);
+
+    if (step->matrix) {
+        layout_matrix(layout, step);
+    } else if (step_label(step)) {
+        pango_layout_set_text(layout, step->above_arrow, -1);
+        pango_layout_get_pixel_size(layout, &step->label_w, &step->label_h);
+    }
+
+    pango_font_description_free(desc);
+    step->laid_out = 1;
+}
+
+/* ---------------- Shared configuration ---------------- */
+void step_layout_configure(PangoContext *context) {
+    /* Explicit values override whatever the target surface would merge in */
+    cairo_font_options_t *options = cairo_font_options_create();
+    cairo_font_options_set_hint_style(options, CAIRO_HINT_STYLE_NONE);
+    cairo_font_options_set_hint_metrics(options, CAIRO_HINT_METRICS_OFF);
+    pango_cairo_context_set_font_options(context, options);
+    cairo_font_options_destroy(options);
+
+    pango_cairo_context_set_resolution(context, LAYOUT_RESOLUTION);
+    pango_context_set_round_glyph_positions(context, FALSE);
+}
+
+PangoLayout *step_layout_create(cairo_t *cr) {
+    PangoContext *context = pango_cairo_create_context(cr);
+    step_layout_configure(context);
+    PangoLayout *layout = pango_layout_new(context);
+    g_object_unref(context);
+    return layout;
+}
+
+/* ---------------- Worker pool ---------------- */
+typedef struct {
+    GMutex lock;
+    GCond done;
+    int pending;    // chunks not finished yet
+} LayoutBatch;
+
+typedef struct {
+    StepList *list;
+    int first;
+    int last;   // exclusive
+    int with_labels;
+    LayoutBatch *batch;
+} LayoutChunk;
+
+// One measuring layout per thread, kept for the life of the thread
+static GPrivate thread_layout_key = G_PRIVATE_INIT(g_object_unref);
+
+static PangoLayout *thread_layout(void) {
+    PangoLayout *layout = g_private_get(&thread_layout_key);
+    if (!layout) {
+        PangoContext *context =
+            pango_font_map_create_context(pango_cairo_font_map_get_default());
+        step_layout_configure(context);
+        layout = pango_layout_new(context);
+        g_object_unref(context);
+        g_private_set(&thread_layout_key, layout);
+    }
+    return layout;
+}
+
+static void layout_range(StepList *list, int first, int last, int with_labels) {
+    PangoLayout *layout = thread_layout();
+    for (int s = first; s < last; s++) {
+        MatrixStep *step = &list->steps[s];
+        if (step->matrix || with_labels) layout_step(layout, step);
+    }
+}
+
+static void layout_chunk(gpointer data, gpointer user_data) {
+    LayoutChunk *chunk = data;
+    LayoutBatch *batch = chunk->batch;
+
+    layout_range(chunk->list, chunk->first, chunk->last, chunk->with_labels);
+    g_free(chunk);
+
+    g_mutex_lock(&batch->lock);
+    if (--batch->pending == 0) g_cond_signal(&batch->done);
+    g_mutex_unlock(&batch->lock);
+}
+
+/* Exclusive threads live as long as the process, so each builds its font map once */
+static gpointer create_layout_pool(gpointer data) {
+    int threads = g_get_num_processors();
+    if (threads <= 1) return NULL;
+    return g_thread_pool_new(layout_chunk, NULL, threads, TRUE, NULL);
+}
+
+static GThreadPool *layout_pool(void) {
+    static GOnce once = G_ONCE_INIT;
+    return g_once(&once, create_layout_pool, NULL);
+}
+
+void precompute_step_layouts(StepList *list, int with_labels) {
+    if (!list->steps || list->count == 0) return;
+
+    long total_cells = 0;
+    for (int s = 0; s < list->count; s++)
+        total_cells += (long)list->steps[s].rows * list->steps[s].cols;
+
+    GThreadPool *pool = total_cells >= LAYOUT_MIN_PARALLEL_CELLS ? layout_pool() : NULL;
+    if (!pool) {
+        layout_range(list, 0, list->count, with_labels);
+        return;
+    }
+
+    /* Split into several chunks per thread so uneven steps still balance */
+    int chunks = g_thread_pool_get_max_threads(pool) * LAYOUT_CHUNKS_PER_THREAD;
+    if (chunks > list->count) chunks = list->count;
+
+    LayoutBatch batch;
+    g_mutex_init(&batch.lock);
+    g_cond_init(&batch.done);
+    batch.pending = chunks;
+
+    for (int c = 0; c < chunks; c++) {
+        LayoutChunk *chunk = g_new(LayoutChunk, 1);
+        chunk->list = list;
+        chunk->first = (int)((long)list->count * c / chunks);
+        chunk->last = (int)((long)list->count * (c + 1) / chunks);
+        chunk->with_labels = with_labels;
+        chunk->batch = &batch;
+        g_thread_pool_push(pool, chunk, NULL);
+    }
+
+    g_mutex_lock(&batch.lock);
+    while (batch.pending > 0) g_cond_wait(&batch.done, &batch.lock);
+    g_mutex_unlock(&batch.lock);
+
+    g_cond_clear(&batch.done);
+    g_mutex_clear(&batch.lock);
+}